@@ -0,0 +1,570 @@
+#include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+#include "c2c_benchmark_bcast.h"
+
+#define MAX_N_READER C2C_BENCHMARK_BCAST_MAX_READER
+
+typedef struct {
+	int32_t writer_core;
+	int32_t n_reader;
+	int32_t reader_cores[MAX_N_READER];
+	int32_t rounds;
+	int32_t record_per_round;
+	int32_t round_interval_ns;
+	uint32_t capacity;
+	int32_t blocking;
+	int32_t sweep;
+	int32_t noisy;
+} args_t;
+
+typedef union {
+	MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+	muggle_atomic_int v;
+} padded_atomic_int_t;
+
+typedef struct {
+	args_t *sys_args;
+	int32_t n_reader;
+	void *mem;
+	time_t base_sec;
+	padded_atomic_int_t n_ready;
+} shared_t;
+
+typedef struct {
+	int32_t idx;
+	shared_t *shared;
+	cache_line_data_t *datas;
+	size_t n_recv;
+	uint32_t n_lost;
+	uint32_t n_lapped;
+} thread_args_t;
+
+typedef struct {
+	double throughput;
+	int64_t ns_per_write;
+	uint64_t n_full;
+} writer_result_t;
+
+typedef struct {
+	int64_t p50; //!< -1 if reader received nothing
+	int64_t p99;
+	size_t n_recv;
+	uint32_t n_lost;
+	uint32_t n_lapped;
+} reader_result_t;
+
+typedef struct {
+	int32_t done; //!< 0 if failed to run
+	writer_result_t writer;
+	reader_result_t readers[MAX_N_READER];
+} row_t;
+
+typedef struct {
+	args_t *args;
+	row_t rows[2][MAX_N_READER + 1]; //!< [noisy][n_reader]
+} sweep_t;
+
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
+{
+	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
+	args->writer_core = -1;
+	args->n_reader = 0;
+	for (int i = 0; i < MAX_N_READER; ++i) {
+		args->reader_cores[i] = -1;
+	}
+	args->rounds = 1000;
+	args->record_per_round = 10;
+	args->round_interval_ns = 1000;
+	args->capacity = 1024;
+	args->blocking = 1;
+	args->sweep = 0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:c:r:m:i:q:o:sN:R:Lh")) != -1) {
+		switch (opt) {
+		case 'p': {
+			args->writer_core = atoi(optarg);
+		} break;
+		case 'c': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				args->reader_cores[args->n_reader++] = atoi(token);
+				token = strtok(NULL, ",");
+				if (args->n_reader >= MAX_N_READER) {
+					break;
+				}
+			}
+		} break;
+		case 'r': {
+			args->rounds = atoi(optarg);
+		} break;
+		case 'm': {
+			args->record_per_round = atoi(optarg);
+		} break;
+		case 'i': {
+			args->round_interval_ns = atoi(optarg);
+		} break;
+		case 'q': {
+			args->capacity = (uint32_t)atoi(optarg);
+		} break;
+		case 'o': {
+			if (strcmp(optarg, "blocking") == 0) {
+				args->blocking = 1;
+			} else if (strcmp(optarg, "overwrite") == 0) {
+				args->blocking = 0;
+			} else {
+				LOG_ERROR("invalid mode: %s", optarg);
+				exit(EXIT_FAILURE);
+			}
+		} break;
+		case 's': {
+			args->sweep = 1;
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
+		case 'h': {
+			printf("Usage of %s:\n"
+				   "  -p int\n"
+				   "    writer bind core\n"
+				   "  -c int array split with comma\n"
+				   "    reader bind cores\n"
+				   "  -r int\n"
+				   "    rounds\n"
+				   "  -m int\n"
+				   "    number of messages per round\n"
+				   "  -i int\n"
+				   "    interval between rounds (nanoseconds)\n"
+				   "  -q int\n"
+				   "    ring capacity in slots, power of 2\n"
+				   "  -o string\n"
+				   "    writer mode, blocking: wait for the slowest reader,\n"
+				   "    overwrite: never wait, slow readers are lapped\n"
+				   "  -s\n"
+				   "    sweep number of readers, from 1 to all reader cores\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   "    with noise, the sweep runs quiet, then again under\n"
+				   "    noise; noise never runs on any reader core, p50/p99\n"
+				   "    under noise and their delta against quiet are added\n"
+				   "    to each reader\n"
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
+				   "\n"
+				   "e.g.\n"
+				   "  %s -p 0 -c 1,2,3,4 -s\n"
+				   "  %s -p 0 -c 1,2,3,4 -o overwrite -q 256\n"
+				   "",
+				   argv[0], argv[0], argv[0]);
+			exit(EXIT_SUCCESS);
+		} break;
+		}
+	}
+}
+
+muggle_thread_ret_t proc_reader(void *p)
+{
+	thread_args_t *p_args = (thread_args_t *)p;
+	shared_t *shared = p_args->shared;
+	args_t *args = shared->sys_args;
+	int32_t bind_core = args->reader_cores[p_args->idx];
+	cache_line_data_t *datas = p_args->datas;
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(bind_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed reader bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("reader bind CPU core #%d", bind_core);
+	}
+
+	// attach ring, as a reader process would do
+	c2c_benchmark_bcast_t ring;
+	c2c_benchmark_bcast_attach(&ring, shared->mem);
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// notify writer ready
+	muggle_atomic_fetch_add(&shared->n_ready.v, 1, muggle_memory_order_release);
+
+	// run reader
+	uint32_t total_cnt = (uint32_t)args->rounds * args->record_per_round;
+	uint32_t next = 0;
+	while (next < total_cnt) {
+		int32_t v0 = 0;
+		int32_t v1 = 0;
+		uint32_t n_lost = 0;
+		ret = c2c_benchmark_bcast_read(&ring, (uint32_t)p_args->idx, &v0, &v1,
+									   &n_lost);
+		if (ret == C2C_BENCHMARK_BCAST_OK) {
+			muggle_time_counter_t *tc = &datas[p_args->n_recv++].tc;
+			muggle_time_counter_end(tc);
+			tc->start_ts.tv_sec = shared->base_sec + v0;
+			tc->start_ts.tv_nsec = v1;
+			++next;
+		} else if (ret == C2C_BENCHMARK_BCAST_LAPPED) {
+			p_args->n_lost += n_lost;
+			++p_args->n_lapped;
+			next += n_lost;
+		}
+	}
+
+	return 0;
+}
+
+void proc_writer(shared_t *shared, writer_result_t *result)
+{
+	args_t *args = shared->sys_args;
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(args->writer_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed writer bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("writer bind CPU core #%d", args->writer_core);
+	}
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// wait readers
+	while (muggle_atomic_load(&shared->n_ready.v,
+							  muggle_memory_order_acquire) != shared->n_reader)
+		;
+
+	// run writer
+	// NOTE: message carries writer timestamp, relative to base_sec so it
+	// fits into two words of slot
+	c2c_benchmark_bcast_t ring;
+	c2c_benchmark_bcast_attach(&ring, shared->mem);
+
+	muggle_time_counter_t total_tc;
+	muggle_time_counter_init(&total_tc);
+	muggle_time_counter_start(&total_tc);
+	for (int r = 0; r < args->rounds; ++r) {
+		for (int i = 0; i < args->record_per_round; ++i) {
+			muggle_time_counter_t tc;
+			muggle_time_counter_start(&tc);
+			int32_t v0 = (int32_t)(tc.start_ts.tv_sec - shared->base_sec);
+			int32_t v1 = (int32_t)tc.start_ts.tv_nsec;
+			while (c2c_benchmark_bcast_write(&ring, v0, v1) != 0) {
+				++result->n_full;
+			}
+		}
+
+		c2c_benchmark_wait_ns(args->round_interval_ns);
+	}
+	muggle_time_counter_end(&total_tc);
+
+	uint64_t total_cnt = (uint64_t)args->rounds * args->record_per_round;
+	int64_t elapsed = muggle_time_counter_interval_ns(&total_tc);
+	int64_t wait_ns = (int64_t)args->rounds * args->round_interval_ns;
+	result->throughput =
+		elapsed > 0 ? (double)total_cnt * 1000000000.0 / elapsed : 0.0;
+	result->ns_per_write =
+		elapsed > wait_ns ? (elapsed - wait_ns) / (int64_t)total_cnt : 0;
+}
+
+void *init_bcast_shm(muggle_shm_t *shm, uint32_t n_bytes)
+{
+	const char *k_name = "/dev/shm/benchmark_c2c_benchmark";
+	const int k_num = 7;
+#if MUGGLE_PLATFORM_WINDOWS
+#else
+	if (!muggle_path_exists(k_name)) {
+		FILE *fp = muggle_os_fopen(k_name, "w");
+		if (fp == NULL) {
+			LOG_ERROR("failed open k_name: %s", k_name);
+			exit(EXIT_FAILURE);
+		}
+		fclose(fp);
+	}
+#endif
+
+	void *mem = muggle_shm_open(shm, k_name, k_num, MUGGLE_SHM_FLAG_CREAT,
+								n_bytes);
+	if (mem == NULL) {
+		LOG_ERROR("failed create shm");
+		return NULL;
+	}
+	LOG_INFO("success create shm: %s, %d, %u bytes", k_name, k_num, n_bytes);
+
+	return mem;
+}
+
+void clear_bcast_shm(muggle_shm_t *shm)
+{
+	if (muggle_shm_detach(shm) != 0) {
+		LOG_ERROR("failed shm detach");
+		return;
+	}
+	LOG_INFO("success shm detach");
+
+	if (muggle_shm_rm(shm) != 0) {
+		LOG_ERROR("failed shm remove");
+		return;
+	}
+	LOG_INFO("success shm remove");
+}
+
+void run_bcast(args_t *args, int32_t n_reader, row_t *row)
+{
+	// prepare datas
+	size_t total_cnt = (size_t)args->rounds * args->record_per_round;
+	cache_line_data_t *r_datas = (cache_line_data_t *)malloc(
+		sizeof(cache_line_data_t) * total_cnt * n_reader);
+	shared_t *shared = (shared_t *)malloc(sizeof(shared_t));
+	if (r_datas == NULL || shared == NULL) {
+		LOG_ERROR("failed allocate datas");
+		free(r_datas);
+		free(shared);
+		return;
+	}
+	for (size_t i = 0; i < total_cnt * n_reader; ++i) {
+		muggle_time_counter_init(&r_datas[i].tc);
+	}
+
+	// prepare ring
+	muggle_shm_t shm;
+	uint32_t n_bytes =
+		(uint32_t)c2c_benchmark_bcast_mem_size(args->capacity, n_reader);
+	void *mem = init_bcast_shm(&shm, n_bytes);
+	if (mem == NULL) {
+		free(r_datas);
+		free(shared);
+		return;
+	}
+	c2c_benchmark_bcast_t ring;
+	if (c2c_benchmark_bcast_init(&ring, mem, args->capacity, n_reader,
+								 args->blocking) != 0) {
+		clear_bcast_shm(&shm);
+		free(r_datas);
+		free(shared);
+		return;
+	}
+
+	muggle_time_counter_t base_tc;
+	muggle_time_counter_start(&base_tc);
+
+	memset(shared, 0, sizeof(*shared));
+	shared->sys_args = args;
+	shared->n_reader = n_reader;
+	shared->mem = mem;
+	shared->base_sec = base_tc.start_ts.tv_sec;
+
+	// run readers
+	thread_args_t th_args[MAX_N_READER];
+	muggle_thread_t th_reader[MAX_N_READER];
+	for (int32_t r = 0; r < n_reader; ++r) {
+		memset(&th_args[r], 0, sizeof(th_args[r]));
+		th_args[r].idx = r;
+		th_args[r].shared = shared;
+		th_args[r].datas = r_datas + r * total_cnt;
+		muggle_thread_create(&th_reader[r], proc_reader, &th_args[r]);
+	}
+
+	// run writer
+	writer_result_t *w_result = &row->writer;
+	memset(w_result, 0, sizeof(*w_result));
+	proc_writer(shared, w_result);
+
+	// cleanup readers
+	for (int32_t r = 0; r < n_reader; ++r) {
+		muggle_thread_join(&th_reader[r]);
+	}
+
+	clear_bcast_shm(&shm);
+
+	// output report
+	const char *mode = args->blocking ? "blocking" : "overwrite";
+	char name[128];
+	snprintf(name, sizeof(name), "bcast_rbuf_%s_n%d%s", mode, n_reader,
+			 args->noisy ? "_noise" : "");
+	for (int32_t r = 0; r < n_reader; ++r) {
+		thread_args_t *th = &th_args[r];
+		cache_line_data_t *datas = th->datas;
+		reader_result_t *r_result = &row->readers[r];
+		r_result->p50 = -1;
+		r_result->p99 = -1;
+		if (th->n_recv > 0) {
+			r_result->p50 = c2c_benchmark_gen_report(
+				name, args->writer_core, args->reader_cores[r], datas,
+				th->n_recv, 0);
+			r_result->p99 = c2c_benchmark_percentile(datas, th->n_recv, 99.0);
+		}
+		r_result->n_recv = th->n_recv;
+		r_result->n_lost = th->n_lost;
+		r_result->n_lapped = th->n_lapped;
+		if (th->n_lost > 0) {
+			LOG_WARNING("reader %d on core %d lapped %u times, lost %u "
+						"messages",
+						r, args->reader_cores[r], th->n_lapped, th->n_lost);
+		}
+	}
+
+	row->done = 1;
+
+	// cleanup datas
+	free(shared);
+	free(r_datas);
+}
+
+/**
+ * @brief run every number of readers, quiet or under noise
+ */
+void run_sweep(void *p, int32_t noisy)
+{
+	sweep_t *sweep = (sweep_t *)p;
+	args_t *args = sweep->args;
+
+	args->noisy = noisy;
+	int32_t n_begin = args->sweep ? 1 : args->n_reader;
+	for (int32_t n = n_begin; n <= args->n_reader; ++n) {
+		run_bcast(args, n, &sweep->rows[noisy][n]);
+	}
+	args->noisy = 0;
+}
+
+/**
+ * @brief print table and summary of sweep, with delta of noise run against
+ * quiet run of each reader if noisy
+ */
+void report_sweep(args_t *args, sweep_t *sweep, int noisy)
+{
+	char reader_cores[256];
+	c2c_benchmark_core_list_str(args->reader_cores, args->n_reader,
+								reader_cores, sizeof(reader_cores));
+	char summary_filepath[MUGGLE_MAX_PATH];
+	snprintf(summary_filepath, sizeof(summary_filepath),
+			 "./c2c_benchmark_reports/summary_bcast_rbuf_%s_c%d_to_c%s.csv",
+			 args->blocking ? "blocking" : "overwrite", args->writer_core,
+			 reader_cores);
+	FILE *fp = muggle_os_fopen(summary_filepath, "w");
+	if (fp) {
+		fprintf(fp, "n_reader,core,p50,p99,recv,lost,lapped,"
+					"writer_msg_per_sec,writer_ns_per_write,writer_full");
+		c2c_benchmark_noise_csv_head(fp, noisy);
+		fprintf(fp, "\n");
+	}
+
+	fprintf(stdout, "%8s%8s%12s%12s%12s%10s%14s%12s%12s", "readers", "core",
+			"p50(ns)", "p99(ns)", "recv", "lost", "w_msg/s", "w_ns/write",
+			"w_full");
+	c2c_benchmark_noise_print_head(stdout, noisy);
+	fprintf(stdout, "\n");
+	int32_t n_begin = args->sweep ? 1 : args->n_reader;
+	for (int32_t n = n_begin; n <= args->n_reader; ++n) {
+		row_t *row = &sweep->rows[0][n];
+		row_t *noise_row = &sweep->rows[1][n];
+		if (!row->done) {
+			LOG_ERROR("failed run with %d readers", n);
+			continue;
+		}
+		writer_result_t *w = &row->writer;
+		for (int32_t r = 0; r < n; ++r) {
+			reader_result_t *rd = &row->readers[r];
+			reader_result_t *noise_rd = &noise_row->readers[r];
+			int64_t noise_p50 = noise_row->done ? noise_rd->p50 : -1;
+			fprintf(stdout, "%8d%8d%12lld%12lld%12lu%10u%14.0f%12lld%12llu",
+					n, args->reader_cores[r], (long long)rd->p50,
+					(long long)rd->p99, (unsigned long)rd->n_recv,
+					rd->n_lost, w->throughput, (long long)w->ns_per_write,
+					(unsigned long long)w->n_full);
+			c2c_benchmark_noise_print_delta(stdout, noisy, rd->p50, rd->p99,
+											noise_p50, noise_rd->p99);
+			fprintf(stdout, "\n");
+			if (fp) {
+				fprintf(fp, "%d,%d,%lld,%lld,%lu,%u,%u,%.0f,%lld,%llu", n,
+						args->reader_cores[r], (long long)rd->p50,
+						(long long)rd->p99, (unsigned long)rd->n_recv,
+						rd->n_lost, rd->n_lapped, w->throughput,
+						(long long)w->ns_per_write,
+						(unsigned long long)w->n_full);
+				c2c_benchmark_noise_csv_delta(fp, noisy, rd->p50, rd->p99,
+											  noise_p50, noise_rd->p99);
+				fprintf(fp, "\n");
+			}
+		}
+	}
+
+	if (fp) {
+		fclose(fp);
+		LOG_INFO("generate summary report: %s", summary_filepath);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	// initialize log
+	if (muggle_log_complicated_init(MUGGLE_LOG_LEVEL_INFO,
+									MUGGLE_LOG_LEVEL_INFO,
+									"logs/c2c_benchmark_bcast_rbuf.log") != 0) {
+		fprintf(stderr, "failed init log\n");
+		exit(EXIT_FAILURE);
+	}
+
+	args_t args;
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
+	LOG_INFO("----------------");
+	LOG_INFO("writer_core: %d", args.writer_core);
+	LOG_INFO("n_reader: %d", args.n_reader);
+	for (int32_t i = 0; i < args.n_reader; ++i) {
+		LOG_INFO("reader_core[%d]: %d", i, args.reader_cores[i]);
+	}
+	LOG_INFO("rounds: %d", args.rounds);
+	LOG_INFO("record_per_round: %d", args.record_per_round);
+	LOG_INFO("round_interval_ns: %d", args.round_interval_ns);
+	LOG_INFO("capacity: %u", args.capacity);
+	LOG_INFO("mode: %s", args.blocking ? "blocking" : "overwrite");
+	LOG_INFO("sweep: %d", args.sweep);
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
+	LOG_INFO("----------------");
+
+	if (args.writer_core == -1 || args.n_reader == 0) {
+		LOG_ERROR("run without writer or reader");
+		exit(EXIT_FAILURE);
+	}
+	if (args.capacity == 0 || (args.capacity & (args.capacity - 1)) != 0) {
+		LOG_ERROR("ring capacity must be power of 2");
+		exit(EXIT_FAILURE);
+	}
+
+	int32_t cores[1 + MAX_N_READER];
+	cores[0] = args.writer_core;
+	memcpy(cores + 1, args.reader_cores, sizeof(int32_t) * args.n_reader);
+	c2c_benchmark_preflight("bcast_rbuf", cores, 1 + args.n_reader);
+
+	sweep_t *sweep = (sweep_t *)malloc(sizeof(sweep_t));
+	if (sweep == NULL) {
+		LOG_ERROR("failed allocate sweep");
+		exit(EXIT_FAILURE);
+	}
+	memset(sweep, 0, sizeof(*sweep));
+	sweep->args = &args;
+	int noisy = c2c_benchmark_noise_run(&noise_args, cores, 1 + args.n_reader,
+										run_sweep, sweep);
+	if (noise_args.n_spec > 0 && !noisy) {
+		fprintf(stdout, "noise skipped\n");
+	}
+	report_sweep(&args, sweep, noisy);
+	free(sweep);
+
+	return 0;
+}
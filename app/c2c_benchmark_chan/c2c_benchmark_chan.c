@@ -1,15 +1,27 @@
 #include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+#include "c2c_benchmark_skew.h"
+#include "c2c_benchmark_depth.h"
 
 #define MAX_N_PRODUCER 32
+#define MAX_N_SWEEP 16
 
 typedef struct {
 	int32_t rounds;
 	int32_t record_per_round;
+	int32_t n_burst;
+	int32_t bursts[MAX_N_SWEEP];
+	uint32_t capacity;
+	int32_t n_capacity;
+	uint32_t capacities[MAX_N_SWEEP];
 	int32_t round_interval_ns;
 	int32_t n_producer;
 	int32_t producer_cores[MAX_N_PRODUCER];
 	int32_t consumer_core;
 	int32_t measure_wr;
+	int32_t skew_threshold_ns;
+	int32_t noisy;
 } args_t;
 
 typedef struct {
@@ -17,13 +29,28 @@ typedef struct {
 	args_t *sys_args;
 	muggle_channel_t *chan;
 	cache_line_data_t *datas;
+	uint64_t n_blocked;
+	int64_t blocked_ns;
 } thread_args_t;
 
-void parse_args(int argc, char **argv, args_t *args)
+typedef struct {
+	int64_t middle_val;
+	uint64_t n_blocked; //!< messages of all producers that hit a full queue
+	int64_t blocked_ns; //!< total time producers were blocked by full queue
+	int32_t depth_computed;
+	c2c_benchmark_depth_t depth;
+} result_t;
+
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
 {
 	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
 	args->rounds = 1000;
 	args->record_per_round = 1;
+	args->n_burst = 0;
+	args->capacity = 1024 * 16;
+	args->n_capacity = 0;
 	args->round_interval_ns = 1000;
 	args->n_producer = 0;
 	for (int i = 0; i < MAX_N_PRODUCER; ++i) {
@@ -33,13 +60,40 @@ void parse_args(int argc, char **argv, args_t *args)
 	args->measure_wr = 1;
 
 	int opt;
-	while ((opt = getopt(argc, argv, "r:m:i:p:c:t:h")) != -1) {
+	while ((opt = getopt(argc, argv, "r:m:q:i:p:c:t:k:N:R:Lh")) != -1) {
 		switch (opt) {
 		case 'r': {
 			args->rounds = atoi(optarg);
 		} break;
 		case 'm': {
-			args->record_per_round = atoi(optarg);
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				int32_t burst = atoi(token);
+				if (burst > 0) {
+					args->bursts[args->n_burst++] = burst;
+				}
+				token = strtok(NULL, ",");
+				if (args->n_burst >= MAX_N_SWEEP) {
+					break;
+				}
+			}
+		} break;
+		case 'q': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				int32_t capacity = atoi(token);
+				if (capacity > 0) {
+					args->capacities[args->n_capacity++] = (uint32_t)capacity;
+				}
+				token = strtok(NULL, ",");
+				if (args->n_capacity >= MAX_N_SWEEP) {
+					break;
+				}
+			}
 		} break;
 		case 'i': {
 			args->round_interval_ns = atoi(optarg);
@@ -68,12 +122,27 @@ void parse_args(int argc, char **argv, args_t *args)
 				LOG_ERROR("invalid measure type");
 			}
 		} break;
+		case 'k': {
+			args->skew_threshold_ns = atoi(optarg);
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
 		case 'h': {
 			printf("Usage of %s:\n"
 				   "  -r int\n"
 				   "    rounds\n"
-				   "  -m int\n"
-				   "    record per round\n"
+				   "  -m int array split with comma\n"
+				   "    record per round, sweep burst size if more than one\n"
+				   "  -q int array split with comma\n"
+				   "    channel capacity, sweep if more than one; default "
+				   "16384\n"
 				   "  -i int\n"
 				   "    round interval (nanoseconds)\n"
 				   "  -p int array split with comma\n"
@@ -82,15 +151,33 @@ void parse_args(int argc, char **argv, args_t *args)
 				   "    consumer bind core\n"
 				   "  -t string\n"
 				   "    measure type; 'w' or 'wr'\n"
+				   "  -k int\n"
+				   "    clock skew threshold (nanoseconds); if > 0 and\n"
+				   "    measure type is 'wr', estimate producer/consumer\n"
+				   "    clock skew before run, correct latency and flag\n"
+				   "    producers whose skew bound exceeds it; latency is\n"
+				   "    not corrected if any skew estimate is invalid\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
 				   "\n"
 				   "e.g.\n"
 				   "  %s -p 0,1,2,3 -c 4\n"
+				   "  %s -p 0 -c 4 -m 1,16,256,4096 -q 256,16384\n"
 				   "",
-				   argv[0], argv[0]);
+				   argv[0], argv[0], argv[0]);
 			exit(EXIT_SUCCESS);
 		} break;
 		}
 	}
+
+	if (args->n_burst == 0) {
+		args->bursts[args->n_burst++] = 1;
+	}
+	if (args->n_capacity == 0) {
+		args->capacities[args->n_capacity++] = args->capacity;
+	}
+	args->record_per_round = args->bursts[0];
+	args->capacity = args->capacities[0];
 }
 
 muggle_thread_ret_t proc_producer(void *p)
@@ -124,13 +211,26 @@ muggle_thread_ret_t proc_producer(void *p)
 		// measure w start -> r end
 		for (int r = 0; r < args->rounds; ++r) {
 			for (int i = 0; i < args->record_per_round; ++i) {
+				int blocked = 0;
+				muggle_time_counter_t block_tc;
 				do {
 					muggle_time_counter_init(&data->tc);
 					muggle_time_counter_start(&data->tc);
 					if (muggle_channel_write(chan, data) == 0) {
 						break;
 					}
+					if (!blocked) {
+						blocked = 1;
+						block_tc = data->tc;
+					}
 				} while (1);
+				if (blocked) {
+					// blocked from the first failed write to the last attempt
+					block_tc.end_ts = data->tc.start_ts;
+					++p_args->n_blocked;
+					p_args->blocked_ns +=
+						muggle_time_counter_interval_ns(&block_tc);
+				}
 				data += 1;
 			}
 
@@ -140,6 +240,8 @@ muggle_thread_ret_t proc_producer(void *p)
 		// measure w start -> w end
 		for (int r = 0; r < args->rounds; ++r) {
 			for (int i = 0; i < args->record_per_round; ++i) {
+				int blocked = 0;
+				muggle_time_counter_t block_tc;
 				do {
 					muggle_time_counter_init(&data->tc);
 					muggle_time_counter_start(&data->tc);
@@ -147,7 +249,18 @@ muggle_thread_ret_t proc_producer(void *p)
 						muggle_time_counter_end(&data->tc);
 						break;
 					}
+					if (!blocked) {
+						blocked = 1;
+						block_tc = data->tc;
+					}
 				} while (1);
+				if (blocked) {
+					// blocked from the first failed write to the last attempt
+					block_tc.end_ts = data->tc.start_ts;
+					++p_args->n_blocked;
+					p_args->blocked_ns +=
+						muggle_time_counter_interval_ns(&block_tc);
+				}
 				data += 1;
 			}
 
@@ -207,8 +320,82 @@ void proc_consumer(args_t *args, muggle_channel_t *chan)
 	LOG_INFO("consumer completed");
 }
 
-void run_chan(args_t *args)
+/**
+ * @brief per producer percentiles and throughput, plus Jain's fairness index
+ * of producer throughputs; (sum x)^2 / (n * sum x^2), 1 means all producers
+ * get equal share and 1/n means a single producer takes all
+ */
+void report_producers(args_t *args, const char *name,
+					  const char *producer_cores, cache_line_data_t *datas)
 {
+	size_t n_per_producer =
+		(size_t)args->rounds * (size_t)args->record_per_round;
+
+	char filepath[MUGGLE_MAX_PATH];
+	snprintf(filepath, sizeof(filepath),
+			 "./c2c_benchmark_reports/producers_%s_c%s_to_c%d.csv", name,
+			 producer_cores, args->consumer_core);
+	FILE *fp = muggle_os_fopen(filepath, "w");
+	if (fp) {
+		fprintf(fp, "producer,core,count,p50,p90,p99,p999,max,throughput\n");
+	}
+
+	double throughputs[MAX_N_PRODUCER];
+	double sum = 0.0;
+	double sum_sq = 0.0;
+	for (int32_t i = 0; i < args->n_producer; ++i) {
+		cache_line_data_t *p_datas = datas + i * n_per_producer;
+		throughputs[i] = c2c_benchmark_throughput(p_datas, n_per_producer);
+		sum += throughputs[i];
+		sum_sq += throughputs[i] * throughputs[i];
+	}
+	double fairness = sum_sq > 0.0 ? (sum * sum) / (args->n_producer * sum_sq)
+									: 0.0;
+	double mean = sum / args->n_producer;
+
+	fprintf(stdout, "%8s%6s%10s%10s%10s%10s%12s%14s\n", "producer", "core",
+			"p50", "p90", "p99", "p99.9", "max", "msg/s");
+	for (int32_t i = 0; i < args->n_producer; ++i) {
+		cache_line_data_t *p_datas = datas + i * n_per_producer;
+		int64_t p50 = c2c_benchmark_percentile(p_datas, n_per_producer, 50.0);
+		int64_t p90 = c2c_benchmark_percentile(p_datas, n_per_producer, 90.0);
+		int64_t p99 = c2c_benchmark_percentile(p_datas, n_per_producer, 99.0);
+		int64_t p999 =
+			c2c_benchmark_percentile(p_datas, n_per_producer, 99.9);
+		int64_t max = c2c_benchmark_percentile(p_datas, n_per_producer, 100.0);
+
+		// a producer far below the mean share is starved by the others
+		int starved = args->n_producer > 1 && throughputs[i] < mean * 0.5;
+		fprintf(stdout, "%8d%6d%10lld%10lld%10lld%10lld%12lld%14.0f%s\n", i,
+				args->producer_cores[i], (long long)p50, (long long)p90,
+				(long long)p99, (long long)p999, (long long)max,
+				throughputs[i], starved ? " [starved]" : "");
+		if (starved) {
+			LOG_WARNING("producer %d (c%d) starved: %.0f msg/s, mean %.0f "
+						"msg/s",
+						i, args->producer_cores[i], throughputs[i], mean);
+		}
+		if (fp) {
+			fprintf(fp, "%d,%d,%llu,%lld,%lld,%lld,%lld,%lld,%.0f\n", i,
+					args->producer_cores[i],
+					(unsigned long long)n_per_producer, (long long)p50,
+					(long long)p90, (long long)p99, (long long)p999,
+					(long long)max, throughputs[i]);
+		}
+	}
+	fprintf(stdout, "fairness(jain): %.4f\n", fairness);
+
+	if (fp) {
+		fclose(fp);
+		LOG_INFO("generate producers report: %s", filepath);
+	}
+}
+
+int64_t run_chan(args_t *args, result_t *result)
+{
+	memset(result, 0, sizeof(*result));
+	result->middle_val = -1;
+
 	// prepare datas
 	size_t total_cnt = (size_t)args->rounds * (size_t)args->record_per_round *
 					   (size_t)args->n_producer;
@@ -216,15 +403,33 @@ void run_chan(args_t *args)
 		(cache_line_data_t *)malloc(sizeof(cache_line_data_t) * total_cnt);
 	if (datas == NULL) {
 		LOG_ERROR("failed allocate datas");
-		return;
+		return -1;
+	}
+
+	// estimate clock skew between each producer and consumer
+	c2c_benchmark_skew_t skews[MAX_N_PRODUCER];
+	int32_t skew_estimated = 0;
+	if (args->measure_wr && args->skew_threshold_ns > 0) {
+		skew_estimated = 1;
+		for (int32_t i = 0; i < args->n_producer; ++i) {
+			if (c2c_benchmark_skew_estimate(args->producer_cores[i],
+											args->consumer_core, 1000,
+											&skews[i]) != 0) {
+				fprintf(stdout,
+						"%d -> %d: skew invalid, latency not corrected\n",
+						args->producer_cores[i], args->consumer_core);
+				skew_estimated = 0;
+			}
+		}
 	}
 
 	// init channel
 	muggle_channel_t chan;
 	int flags = MUGGLE_CHANNEL_FLAG_WRITE_SPIN | MUGGLE_CHANNEL_FLAG_READ_BUSY;
-	if (muggle_channel_init(&chan, 1024 * 16, flags) != 0) {
+	if (muggle_channel_init(&chan, args->capacity, flags) != 0) {
 		LOG_ERROR("failed init channel");
-		return;
+		free(datas);
+		return -1;
 	}
 
 	// run producer
@@ -236,6 +441,8 @@ void run_chan(args_t *args)
 		th_args[i].chan = &chan;
 		th_args[i].datas =
 			datas + i * (size_t)args->rounds * (size_t)args->record_per_round;
+		th_args[i].n_blocked = 0;
+		th_args[i].blocked_ns = 0;
 		muggle_thread_create(&th_producer[i], proc_producer, &th_args[i]);
 	}
 
@@ -245,19 +452,157 @@ void run_chan(args_t *args)
 	// cleanup producer
 	for (int32_t i = 0; i < args->n_producer; ++i) {
 		muggle_thread_join(&th_producer[i]);
+		result->n_blocked += th_args[i].n_blocked;
+		result->blocked_ns += th_args[i].blocked_ns;
 	}
 
 	// cleanup channel
 	muggle_channel_destroy(&chan);
 
+	// correct one-way latency with clock skew of each producer
+	if (skew_estimated) {
+		size_t n_per_producer =
+			(size_t)args->rounds * (size_t)args->record_per_round;
+		for (int32_t i = 0; i < args->n_producer; ++i) {
+			c2c_benchmark_skew_correct(&skews[i], datas + i * n_per_producer,
+									   n_per_producer);
+
+			int64_t bound = c2c_benchmark_skew_bound(&skews[i]);
+			int exceeded = bound > args->skew_threshold_ns;
+			if (exceeded) {
+				LOG_WARNING("c%d -> c%d clock skew bound %lld ns exceeds "
+							"threshold %d ns",
+							args->producer_cores[i], args->consumer_core,
+							(long long)bound, args->skew_threshold_ns);
+			}
+			fprintf(stdout, "%d -> %d: skew offset %lld +-%lld ns%s\n",
+					args->producer_cores[i], args->consumer_core,
+					(long long)skews[i].offset_ns,
+					(long long)skews[i].error_ns,
+					exceeded ? " [exceeds threshold]" : "");
+		}
+	}
+
 	// output report
 	char name[128];
-	snprintf(name, sizeof(name), "chan_%s", args->measure_wr ? "wr" : "w");
-	c2c_benchmark_gen_report(name, args->n_producer, args->consumer_core, datas,
-							 total_cnt, 0);
+	char sweep_suffix[32] = "";
+	int offset = 0;
+	if (args->n_burst > 1) {
+		offset += snprintf(sweep_suffix + offset, sizeof(sweep_suffix) - offset,
+						   "_m%d", args->record_per_round);
+	}
+	if (args->n_capacity > 1) {
+		snprintf(sweep_suffix + offset, sizeof(sweep_suffix) - offset, "_q%u",
+				 args->capacity);
+	}
+	snprintf(name, sizeof(name), "chan_%s%s%s", args->measure_wr ? "wr" : "w",
+			 sweep_suffix, args->noisy ? "_noise" : "");
+	char producer_cores[256];
+	char consumer_cores[16];
+	c2c_benchmark_core_list_str(args->producer_cores, args->n_producer,
+								producer_cores, sizeof(producer_cores));
+	snprintf(consumer_cores, sizeof(consumer_cores), "%d",
+			 args->consumer_core);
+	report_producers(args, name, producer_cores, datas);
+
+	// queue depth at dequeue, only w start -> r end has dequeue timestamps
+	if (args->measure_wr &&
+		c2c_benchmark_depth_compute(datas, total_cnt, &result->depth) == 0) {
+		result->depth_computed = 1;
+		c2c_benchmark_depth_report(name, producer_cores, consumer_cores,
+								   &result->depth);
+		c2c_benchmark_depth_print(stdout, &result->depth);
+	}
+	fprintf(stdout, "blocked writes: %llu/%llu, blocked time: %lld ns\n",
+			(unsigned long long)result->n_blocked,
+			(unsigned long long)total_cnt, (long long)result->blocked_ns);
+
+	result->middle_val = c2c_benchmark_gen_report_cores(
+		name, producer_cores, consumer_cores, datas, total_cnt, 0);
 
 	// cleanup datas
 	free(datas);
+
+	return result->middle_val;
+}
+
+typedef struct {
+	args_t *args;
+	result_t *results[2]; //!< quiet and noise result
+} pair_run_t;
+
+/**
+ * @brief run channel quiet or under noise
+ */
+static void run_pair(void *p, int32_t noisy)
+{
+	pair_run_t *run = (pair_run_t *)p;
+	run->args->noisy = noisy;
+	run_chan(run->args, run->results[noisy]);
+	run->args->noisy = 0;
+}
+
+/**
+ * @brief summary of burst size and capacity sweep; backpressure of a
+ * capacity starts at the smallest burst that makes any message hit a full
+ * queue
+ */
+void report_sweep(args_t *args, result_t *results)
+{
+	char producer_cores[256];
+	c2c_benchmark_core_list_str(args->producer_cores, args->n_producer,
+								producer_cores, sizeof(producer_cores));
+	char filepath[MUGGLE_MAX_PATH];
+	snprintf(filepath, sizeof(filepath),
+			 "./c2c_benchmark_reports/summary_chan_%s_c%s_to_c%d.csv",
+			 args->measure_wr ? "wr" : "w", producer_cores,
+			 args->consumer_core);
+	FILE *fp = muggle_os_fopen(filepath, "w");
+	if (fp) {
+		fprintf(fp, "capacity,burst,p50,depth_p50,depth_p99,depth_max,"
+					"blocked,blocked_ns\n");
+	}
+
+	fprintf(stdout, "%10s%8s%12s%10s%10s%10s%10s%14s\n", "capacity", "burst",
+			"p50(ns)", "depth50", "depth99", "depth_max", "blocked",
+			"blocked(ns)");
+	for (int32_t q = 0; q < args->n_capacity; ++q) {
+		int32_t backpressure_burst = -1;
+		for (int32_t m = 0; m < args->n_burst; ++m) {
+			result_t *result = &results[q * args->n_burst + m];
+			c2c_benchmark_depth_t *depth = &result->depth;
+			if (result->n_blocked > 0 &&
+				(backpressure_burst == -1 ||
+				 args->bursts[m] < backpressure_burst)) {
+				backpressure_burst = args->bursts[m];
+			}
+			fprintf(stdout, "%10u%8d%12lld%10d%10d%10d%10llu%14lld\n",
+					args->capacities[q], args->bursts[m],
+					(long long)result->middle_val, depth->p50, depth->p99,
+					depth->max, (unsigned long long)result->n_blocked,
+					(long long)result->blocked_ns);
+			if (fp) {
+				fprintf(fp, "%u,%d,%lld,%d,%d,%d,%llu,%lld\n",
+						args->capacities[q], args->bursts[m],
+						(long long)result->middle_val, depth->p50, depth->p99,
+						depth->max, (unsigned long long)result->n_blocked,
+						(long long)result->blocked_ns);
+			}
+		}
+
+		if (backpressure_burst == -1) {
+			fprintf(stdout, "capacity %u: no backpressure\n",
+					args->capacities[q]);
+		} else {
+			fprintf(stdout, "capacity %u: backpressure from burst %d\n",
+					args->capacities[q], backpressure_burst);
+		}
+	}
+
+	if (fp) {
+		fclose(fp);
+		LOG_INFO("generate summary report: %s", filepath);
+	}
 }
 
 int main(int argc, char *argv[])
@@ -271,10 +616,16 @@ int main(int argc, char *argv[])
 	}
 
 	args_t args;
-	parse_args(argc, argv, &args);
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
 	LOG_INFO("----------------");
 	LOG_INFO("rounds: %d", args.rounds);
-	LOG_INFO("record_per_round: %d", args.record_per_round);
+	for (int32_t i = 0; i < args.n_burst; ++i) {
+		LOG_INFO("record_per_round[%d]: %d", i, args.bursts[i]);
+	}
+	for (int32_t i = 0; i < args.n_capacity; ++i) {
+		LOG_INFO("capacity[%d]: %u", i, args.capacities[i]);
+	}
 	LOG_INFO("round_interval_ns: %d", args.round_interval_ns);
 	LOG_INFO("n_producer: %d", args.n_producer);
 	for (int32_t i = 0; i < args.n_producer; ++i) {
@@ -283,6 +634,10 @@ int main(int argc, char *argv[])
 	LOG_INFO("consumer_core: %d", args.consumer_core);
 	LOG_INFO("measure type: %s",
 			 args.measure_wr ? "w start -> r end" : "w start -> w end");
+	LOG_INFO("skew_threshold_ns: %d", args.skew_threshold_ns);
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
 	LOG_INFO("----------------");
 
 	if (args.n_producer == 0) {
@@ -290,7 +645,56 @@ int main(int argc, char *argv[])
 		exit(EXIT_FAILURE);
 	}
 
-	run_chan(&args);
+	int32_t cores[MAX_N_PRODUCER + 1];
+	memcpy(cores, args.producer_cores, sizeof(int32_t) * args.n_producer);
+	cores[args.n_producer] = args.consumer_core;
+	c2c_benchmark_preflight("chan", cores, args.n_producer + 1);
+
+	int32_t n_run = args.n_capacity * args.n_burst;
+	result_t *results = (result_t *)malloc(sizeof(result_t) * n_run);
+	if (results == NULL) {
+		LOG_ERROR("failed allocate results");
+		exit(EXIT_FAILURE);
+	}
+
+	int32_t measured_cores[MAX_N_PRODUCER + 1];
+	memcpy(measured_cores, args.producer_cores,
+		   sizeof(int32_t) * args.n_producer);
+	measured_cores[args.n_producer] = args.consumer_core;
+	for (int32_t q = 0; q < args.n_capacity; ++q) {
+		for (int32_t m = 0; m < args.n_burst; ++m) {
+			args.capacity = args.capacities[q];
+			args.record_per_round = args.bursts[m];
+			if (n_run > 1) {
+				fprintf(stdout, "capacity %u, burst %d:\n", args.capacity,
+						args.record_per_round);
+			}
+
+			result_t noise_result;
+			pair_run_t run;
+			run.args = &args;
+			run.results[0] = &results[q * args.n_burst + m];
+			run.results[1] = &noise_result;
+			int noisy = c2c_benchmark_noise_run(
+				&noise_args, measured_cores, args.n_producer + 1, run_pair,
+				&run);
+			int64_t middle_val = run.results[0]->middle_val;
+			if (noise_args.n_spec > 0 && !noisy) {
+				fprintf(stdout, "quiet %lld, noise skipped\n",
+						(long long)middle_val);
+			} else if (noisy) {
+				int64_t noise_val = noise_result.middle_val;
+				fprintf(stdout, "quiet %lld, noise %lld, delta %lld\n",
+						(long long)middle_val, (long long)noise_val,
+						(long long)(noise_val - middle_val));
+			}
+		}
+	}
+
+	if (n_run > 1) {
+		report_sweep(&args, results);
+	}
+	free(results);
 
 	return 0;
 }
@@ -0,0 +1,476 @@
+#include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+
+#define MAX_N_READER 64
+
+typedef struct {
+	int32_t writer_core;
+	int32_t n_reader;
+	int32_t reader_cores[MAX_N_READER];
+	int32_t total_cnt;
+	int32_t round_interval_ns;
+	int32_t sweep;
+	int32_t noisy;
+} args_t;
+
+typedef union {
+	MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+	muggle_atomic_int v;
+} padded_atomic_int_t;
+
+typedef struct {
+	args_t *sys_args;
+	int32_t n_reader;
+	padded_atomic_int_t seq;
+	padded_atomic_int_t acks[MAX_N_READER];
+} shared_t;
+
+typedef struct {
+	int32_t idx;
+	shared_t *shared;
+	cache_line_data_t *datas;
+} thread_args_t;
+
+typedef struct {
+	int64_t p50; //!< -1 if failed
+	int64_t p99;
+} val_t;
+
+typedef struct {
+	val_t store;
+	val_t last;
+	val_t readers[MAX_N_READER];
+} row_t;
+
+typedef struct {
+	args_t *args;
+	row_t rows[2][MAX_N_READER + 1]; //!< [noisy][n_reader]
+} sweep_t;
+
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
+{
+	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
+	args->writer_core = -1;
+	args->n_reader = 0;
+	for (int i = 0; i < MAX_N_READER; ++i) {
+		args->reader_cores[i] = -1;
+	}
+	args->total_cnt = 10000;
+	args->round_interval_ns = 0;
+	args->sweep = 0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:c:n:i:sN:R:Lh")) != -1) {
+		switch (opt) {
+		case 'p': {
+			args->writer_core = atoi(optarg);
+		} break;
+		case 'c': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				args->reader_cores[args->n_reader++] = atoi(token);
+				token = strtok(NULL, ",");
+				if (args->n_reader >= MAX_N_READER) {
+					break;
+				}
+			}
+		} break;
+		case 'n': {
+			args->total_cnt = atoi(optarg);
+		} break;
+		case 'i': {
+			args->round_interval_ns = atoi(optarg);
+		} break;
+		case 's': {
+			args->sweep = 1;
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
+		case 'h': {
+			printf("Usage of %s:\n"
+				   "  -p int\n"
+				   "    writer bind core\n"
+				   "  -c int array split with comma\n"
+				   "    reader bind cores\n"
+				   "  -n int\n"
+				   "    total count\n"
+				   "  -i int\n"
+				   "    interval between writes (nanoseconds)\n"
+				   "  -s\n"
+				   "    sweep number of readers, from 1 to all reader cores\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   "    with noise, the sweep runs quiet, then again under\n"
+				   "    noise; noise never runs on any reader core, 'last'\n"
+				   "    p50/p99 under noise and their delta against quiet\n"
+				   "    are added to each row\n"
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
+				   "\n"
+				   "e.g.\n"
+				   "  %s -p 0 -c 1,2,3,4 -s\n"
+				   "",
+				   argv[0], argv[0]);
+			exit(EXIT_SUCCESS);
+		} break;
+		}
+	}
+}
+
+muggle_thread_ret_t proc_reader(void *p)
+{
+	thread_args_t *p_args = (thread_args_t *)p;
+	shared_t *shared = p_args->shared;
+	args_t *args = shared->sys_args;
+	int32_t bind_core = args->reader_cores[p_args->idx];
+	muggle_atomic_int *ack = &shared->acks[p_args->idx].v;
+	cache_line_data_t *datas = p_args->datas;
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(bind_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed reader bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("reader bind CPU core #%d", bind_core);
+	}
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// notify writer ready
+	muggle_atomic_store(ack, -1, muggle_memory_order_release);
+
+	// run reader
+	for (int32_t i = 0; i < args->total_cnt; ++i) {
+		while (muggle_atomic_load(&shared->seq.v,
+								  muggle_memory_order_acquire) != i)
+			;
+		muggle_time_counter_end(&datas[i].tc);
+		muggle_atomic_store(ack, i, muggle_memory_order_release);
+	}
+
+	return 0;
+}
+
+static void wait_readers(shared_t *shared, int32_t v)
+{
+	for (int32_t r = 0; r < shared->n_reader; ++r) {
+		while (muggle_atomic_load(&shared->acks[r].v,
+								  muggle_memory_order_acquire) != v)
+			;
+	}
+}
+
+void proc_writer(shared_t *shared, cache_line_data_t *datas)
+{
+	args_t *args = shared->sys_args;
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(args->writer_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed writer bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("writer bind CPU core #%d", args->writer_core);
+	}
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// run writer
+	// NOTE: seq_cst store drains the store buffer, so the end timestamp
+	// includes invalidating the copies held by all readers
+	for (int32_t i = 0; i < args->total_cnt; ++i) {
+		wait_readers(shared, i - 1);
+		if (args->round_interval_ns > 0) {
+			c2c_benchmark_wait_ns(args->round_interval_ns);
+		}
+
+		muggle_time_counter_start(&datas[i].tc);
+		muggle_atomic_store(&shared->seq.v, i, muggle_memory_order_seq_cst);
+		muggle_time_counter_end(&datas[i].tc);
+	}
+	wait_readers(shared, args->total_cnt - 1);
+}
+
+static void set_val(val_t *val, int64_t p50, cache_line_data_t *datas,
+					size_t total_cnt)
+{
+	val->p50 = p50;
+	val->p99 = c2c_benchmark_percentile(datas, total_cnt, 99.0);
+}
+
+void run_fanout(args_t *args, int32_t n_reader, row_t *row)
+{
+	// prepare datas
+	size_t total_cnt = (size_t)args->total_cnt;
+	cache_line_data_t *w_datas =
+		(cache_line_data_t *)malloc(sizeof(cache_line_data_t) * total_cnt);
+	cache_line_data_t *r_datas = (cache_line_data_t *)malloc(
+		sizeof(cache_line_data_t) * total_cnt * (n_reader + 1));
+	shared_t *shared = (shared_t *)malloc(sizeof(shared_t));
+	row->last.p50 = -1;
+	row->store.p50 = -1;
+	if (w_datas == NULL || r_datas == NULL || shared == NULL) {
+		LOG_ERROR("failed allocate datas");
+		free(w_datas);
+		free(r_datas);
+		free(shared);
+		return;
+	}
+	for (size_t i = 0; i < total_cnt; ++i) {
+		muggle_time_counter_init(&w_datas[i].tc);
+	}
+
+	memset(shared, 0, sizeof(*shared));
+	shared->sys_args = args;
+	shared->n_reader = n_reader;
+	shared->seq.v = -1;
+	for (int32_t r = 0; r < n_reader; ++r) {
+		shared->acks[r].v = -2;
+	}
+
+	// run readers
+	thread_args_t th_args[MAX_N_READER];
+	muggle_thread_t th_reader[MAX_N_READER];
+	for (int32_t r = 0; r < n_reader; ++r) {
+		th_args[r].idx = r;
+		th_args[r].shared = shared;
+		th_args[r].datas = r_datas + r * total_cnt;
+		muggle_thread_create(&th_reader[r], proc_reader, &th_args[r]);
+	}
+
+	// run writer
+	proc_writer(shared, w_datas);
+
+	// cleanup readers
+	for (int32_t r = 0; r < n_reader; ++r) {
+		muggle_thread_join(&th_reader[r]);
+	}
+
+	// observation latency: writer start -> reader observe
+	cache_line_data_t *last_datas = r_datas + n_reader * total_cnt;
+	for (size_t i = 0; i < total_cnt; ++i) {
+		last_datas[i].tc = r_datas[i].tc;
+		for (int32_t r = 0; r < n_reader; ++r) {
+			muggle_time_counter_t *tc = &r_datas[r * total_cnt + i].tc;
+			tc->start_ts = w_datas[i].tc.start_ts;
+
+			muggle_time_counter_t *last = &last_datas[i].tc;
+			if (tc->end_ts.tv_sec > last->end_ts.tv_sec ||
+				(tc->end_ts.tv_sec == last->end_ts.tv_sec &&
+				 tc->end_ts.tv_nsec > last->end_ts.tv_nsec)) {
+				last->end_ts = tc->end_ts;
+			}
+		}
+		last_datas[i].tc.start_ts = w_datas[i].tc.start_ts;
+	}
+
+	// output report
+	char name[128];
+	char writer_core[16];
+	char reader_cores[256];
+	snprintf(writer_core, sizeof(writer_core), "%d", args->writer_core);
+	c2c_benchmark_core_list_str(args->reader_cores, n_reader, reader_cores,
+								sizeof(reader_cores));
+
+	const char *noise_suffix = args->noisy ? "_noise" : "";
+	snprintf(name, sizeof(name), "fanout_n%d_store%s", n_reader,
+			 noise_suffix);
+	set_val(&row->store,
+			c2c_benchmark_gen_report_cores(name, writer_core, reader_cores,
+										   w_datas, total_cnt, 0),
+			w_datas, total_cnt);
+
+	for (int32_t r = 0; r < n_reader; ++r) {
+		snprintf(name, sizeof(name), "fanout_n%d%s", n_reader, noise_suffix);
+		cache_line_data_t *datas = r_datas + r * total_cnt;
+		set_val(&row->readers[r],
+				c2c_benchmark_gen_report(name, args->writer_core,
+										 args->reader_cores[r], datas,
+										 total_cnt, 0),
+				datas, total_cnt);
+	}
+
+	snprintf(name, sizeof(name), "fanout_n%d_last%s", n_reader,
+			 noise_suffix);
+	set_val(&row->last,
+			c2c_benchmark_gen_report_cores(name, writer_core, reader_cores,
+										   last_datas, total_cnt, 0),
+			last_datas, total_cnt);
+
+	// cleanup datas
+	free(shared);
+	free(r_datas);
+	free(w_datas);
+}
+
+/**
+ * @brief run every number of readers, quiet or under noise
+ */
+void run_sweep(void *p, int32_t noisy)
+{
+	sweep_t *sweep = (sweep_t *)p;
+	args_t *args = sweep->args;
+
+	args->noisy = noisy;
+	int32_t n_begin = args->sweep ? 1 : args->n_reader;
+	for (int32_t n = n_begin; n <= args->n_reader; ++n) {
+		run_fanout(args, n, &sweep->rows[noisy][n]);
+	}
+	args->noisy = 0;
+}
+
+static void report_val(FILE *fp, int noisy, int32_t n_reader,
+					   const char *type, const char *core, val_t *val,
+					   val_t *noise_val)
+{
+	fprintf(fp, "%d,%s,%s,%lld", n_reader, type, core, (long long)val->p50);
+	c2c_benchmark_noise_csv_delta(fp, noisy, val->p50, val->p99,
+								  noise_val->p50, noise_val->p99);
+	fprintf(fp, "\n");
+}
+
+/**
+ * @brief print table and summary of sweep; under noise, table shows delta
+ * of 'last', summary shows delta of every row
+ */
+void report_sweep(args_t *args, sweep_t *sweep, int noisy)
+{
+	char reader_cores[256];
+	c2c_benchmark_core_list_str(args->reader_cores, args->n_reader,
+								reader_cores, sizeof(reader_cores));
+	char summary_filepath[MUGGLE_MAX_PATH];
+	snprintf(summary_filepath, sizeof(summary_filepath),
+			 "./c2c_benchmark_reports/summary_fanout_c%d_to_c%s.csv",
+			 args->writer_core, reader_cores);
+	FILE *fp = muggle_os_fopen(summary_filepath, "w");
+	if (fp) {
+		fprintf(fp, "n_reader,type,core,elapsed");
+		c2c_benchmark_noise_csv_head(fp, noisy);
+		fprintf(fp, "\n");
+	}
+
+	fprintf(stdout, "%8s%12s%12s%12s%12s", "readers", "store(ns)",
+			"min_rd(ns)", "max_rd(ns)", "last(ns)");
+	c2c_benchmark_noise_print_head(stdout, noisy);
+	fprintf(stdout, "\n");
+	int32_t n_begin = args->sweep ? 1 : args->n_reader;
+	for (int32_t n = n_begin; n <= args->n_reader; ++n) {
+		row_t *row = &sweep->rows[0][n];
+		row_t *noise_row = &sweep->rows[1][n];
+		if (row->last.p50 < 0) {
+			LOG_ERROR("failed run with %d readers", n);
+			continue;
+		}
+
+		int64_t min_val = INT64_MAX;
+		int64_t max_val = 0;
+		for (int32_t r = 0; r < n; ++r) {
+			int64_t val = row->readers[r].p50;
+			if (val < min_val) {
+				min_val = val;
+			}
+			if (val > max_val) {
+				max_val = val;
+			}
+			if (fp) {
+				char core[16];
+				snprintf(core, sizeof(core), "%d", args->reader_cores[r]);
+				report_val(fp, noisy, n, "reader", core, &row->readers[r],
+						   &noise_row->readers[r]);
+			}
+		}
+		if (fp) {
+			char core[16];
+			snprintf(core, sizeof(core), "%d", args->writer_core);
+			report_val(fp, noisy, n, "store", core, &row->store,
+					   &noise_row->store);
+			c2c_benchmark_core_list_str(args->reader_cores, n, reader_cores,
+										sizeof(reader_cores));
+			report_val(fp, noisy, n, "last", reader_cores, &row->last,
+					   &noise_row->last);
+		}
+
+		fprintf(stdout, "%8d%12lld%12lld%12lld%12lld", n,
+				(long long)row->store.p50, (long long)min_val,
+				(long long)max_val, (long long)row->last.p50);
+		c2c_benchmark_noise_print_delta(stdout, noisy, row->last.p50,
+										row->last.p99, noise_row->last.p50,
+										noise_row->last.p99);
+		fprintf(stdout, "\n");
+	}
+
+	if (fp) {
+		fclose(fp);
+		LOG_INFO("generate summary report: %s", summary_filepath);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	// initialize log
+	if (muggle_log_complicated_init(MUGGLE_LOG_LEVEL_INFO,
+									MUGGLE_LOG_LEVEL_INFO,
+									"logs/c2c_benchmark_fanout.log") != 0) {
+		fprintf(stderr, "failed init log\n");
+		exit(EXIT_FAILURE);
+	}
+
+	args_t args;
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
+	LOG_INFO("----------------");
+	LOG_INFO("writer_core: %d", args.writer_core);
+	LOG_INFO("n_reader: %d", args.n_reader);
+	for (int32_t i = 0; i < args.n_reader; ++i) {
+		LOG_INFO("reader_core[%d]: %d", i, args.reader_cores[i]);
+	}
+	LOG_INFO("total_cnt: %d", args.total_cnt);
+	LOG_INFO("round_interval_ns: %d", args.round_interval_ns);
+	LOG_INFO("sweep: %d", args.sweep);
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
+	LOG_INFO("----------------");
+
+	if (args.writer_core == -1 || args.n_reader == 0) {
+		LOG_ERROR("run without writer or reader");
+		exit(EXIT_FAILURE);
+	}
+
+	int32_t cores[1 + MAX_N_READER];
+	cores[0] = args.writer_core;
+	memcpy(cores + 1, args.reader_cores, sizeof(int32_t) * args.n_reader);
+	c2c_benchmark_preflight("fanout", cores, 1 + args.n_reader);
+
+	sweep_t *sweep = (sweep_t *)malloc(sizeof(sweep_t));
+	if (sweep == NULL) {
+		LOG_ERROR("failed allocate sweep");
+		exit(EXIT_FAILURE);
+	}
+	memset(sweep, 0, sizeof(*sweep));
+	sweep->args = &args;
+	int noisy = c2c_benchmark_noise_run(&noise_args, cores, 1 + args.n_reader,
+										run_sweep, sweep);
+	if (noise_args.n_spec > 0 && !noisy) {
+		fprintf(stdout, "noise skipped\n");
+	}
+	report_sweep(&args, sweep, noisy);
+	free(sweep);
+
+	return 0;
+}
@@ -0,0 +1,877 @@
+#include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+#include "c2c_benchmark_spsc.h"
+
+#if MUGGLE_PLATFORM_LINUX
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <sys/eventfd.h>
+	#include <sys/syscall.h>
+	#include <linux/futex.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <arpa/inet.h>
+	#include <fcntl.h>
+
+	#define TRANSPORT_SHM 0
+	#define TRANSPORT_SPSC 1
+	#define TRANSPORT_PIPE 2
+	#define TRANSPORT_UDS_STREAM 3
+	#define TRANSPORT_UDS_DGRAM 4
+	#define TRANSPORT_EVENTFD 5
+	#define TRANSPORT_FUTEX 6
+	#define TRANSPORT_TCP 7
+	#define TRANSPORT_UDP 8
+	#define TRANSPORT_MAX 9
+
+	#define IPC_RECV_TIMEOUT_SEC 3
+
+typedef struct {
+	int32_t rounds;
+	int32_t record_per_round;
+	int32_t round_interval_ns;
+	int32_t producer_core;
+	int32_t consumer_core;
+	int32_t n_transport;
+	int32_t transports[TRANSPORT_MAX];
+	int32_t noisy;
+} args_t;
+
+typedef struct {
+	int64_t p50; //!< latency percentiles of paced phase
+	int64_t p90;
+	int64_t p99;
+	int64_t max;
+	double throughput; //!< throughput of burst phase
+	int64_t burst_p50; //!< latency under backlog, burst phase
+	size_t n_recv;
+	size_t n_lost; //!< messages consumer missed in paced phase
+	size_t burst_lost; //!< messages consumer missed in burst phase
+} result_t;
+
+typedef struct {
+	args_t *args;
+	result_t results[2][TRANSPORT_MAX]; //!< quiet and noise
+	int32_t succeed[2][TRANSPORT_MAX];
+} run_t;
+
+/**
+ * @brief producer -> consumer queue
+ *
+ * fds[0] is consumer side and fds[1] is producer side; eventfd and futex
+ * transports carry messages in spsc ring and only use kernel to wake
+ * consumer
+ */
+typedef struct {
+	int32_t transport;
+	int fds[2];
+	muggle_shm_t shm;
+	muggle_shm_ringbuf_t *shm_rbuf;
+	c2c_benchmark_spsc_t spsc;
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+		muggle_atomic_int futex_word;
+	};
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(1);
+		muggle_atomic_int n_acked; //!< received in paced phase, -1 if stop
+	};
+} ipc_queue_t;
+
+typedef struct {
+	args_t *sys_args;
+	ipc_queue_t *q;
+	int32_t paced;
+	size_t total_cnt;
+	cache_line_data_t *datas;
+	size_t n_recv;
+} thread_args_t;
+
+static const char *s_transport_names[TRANSPORT_MAX] = {
+	"shm", "spsc", "pipe", "uds_stream", "uds_dgram",
+	"eventfd", "futex", "tcp", "udp",
+};
+
+static int32_t transport_from_name(const char *name)
+{
+	for (int32_t i = 0; i < TRANSPORT_MAX; ++i) {
+		if (strcmp(name, s_transport_names[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
+{
+	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
+	args->rounds = 1000;
+	args->record_per_round = 1;
+	args->round_interval_ns = 1000;
+	args->producer_core = -1;
+	args->consumer_core = -1;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "r:m:i:p:c:t:N:R:Lh")) != -1) {
+		switch (opt) {
+		case 'r': {
+			args->rounds = atoi(optarg);
+		} break;
+		case 'm': {
+			args->record_per_round = atoi(optarg);
+		} break;
+		case 'i': {
+			args->round_interval_ns = atoi(optarg);
+		} break;
+		case 'p': {
+			args->producer_core = atoi(optarg);
+		} break;
+		case 'c': {
+			args->consumer_core = atoi(optarg);
+		} break;
+		case 't': {
+			char *token = strtok(optarg, ",");
+			while (token != NULL && args->n_transport < TRANSPORT_MAX) {
+				int32_t transport = transport_from_name(token);
+				if (transport == -1) {
+					LOG_ERROR("invalid transport: %s", token);
+					exit(EXIT_FAILURE);
+				}
+				args->transports[args->n_transport++] = transport;
+				token = strtok(NULL, ",");
+			}
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
+		case 'h': {
+			printf("Usage of %s:\n"
+				   "  -r int\n"
+				   "    rounds\n"
+				   "  -m int\n"
+				   "    record per round of burst phase\n"
+				   "  -i int\n"
+				   "    round interval (nanoseconds)\n"
+				   "  -p int\n"
+				   "    producer bind core\n"
+				   "  -c int\n"
+				   "    consumer bind core\n"
+				   "  -t string array split with comma\n"
+				   "    transports, default all; 'shm', 'spsc', 'pipe',\n"
+				   "    'uds_stream', 'uds_dgram', 'eventfd', 'futex', 'tcp'\n"
+				   "    or 'udp'\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   "    with noise, all transports run quiet, then again\n"
+				   "    under noise; paced p50/p99 under noise and their\n"
+				   "    delta against quiet are added to each transport\n"
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
+				   "\n"
+				   "each transport runs two phases:\n"
+				   "  paced  one message per round, the next one is sent\n"
+				   "         after consumer got it, latency without backlog\n"
+				   "  burst  rounds of messages, throughput and latency\n"
+				   "         under backlog\n"
+				   "lost and b_lost count messages consumer missed in\n"
+				   "paced and burst phase; msg/s is marked '*' when burst\n"
+				   "lost any, it only counts messages consumer got\n"
+				   "\n"
+				   "e.g.\n"
+				   "  %s -p 0 -c 1 -t shm,pipe,eventfd\n"
+				   "",
+				   argv[0], argv[0]);
+			exit(EXIT_SUCCESS);
+		} break;
+		}
+	}
+
+	if (args->n_transport == 0) {
+		for (int32_t i = 0; i < TRANSPORT_MAX; ++i) {
+			args->transports[args->n_transport++] = i;
+		}
+	}
+}
+
+static int ipc_socket_timeout(int fd)
+{
+	struct timeval tv;
+	tv.tv_sec = IPC_RECV_TIMEOUT_SEC;
+	tv.tv_usec = 0;
+	return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+static int ipc_tcp_init(ipc_queue_t *q)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof(addr);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+
+	int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_fd == -1) {
+		return -1;
+	}
+	if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+		listen(listen_fd, 1) != 0 ||
+		getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+		close(listen_fd);
+		return -1;
+	}
+
+	q->fds[1] = socket(AF_INET, SOCK_STREAM, 0);
+	if (q->fds[1] == -1 ||
+		connect(q->fds[1], (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		close(listen_fd);
+		return -1;
+	}
+	q->fds[0] = accept(listen_fd, NULL, NULL);
+	close(listen_fd);
+	if (q->fds[0] == -1) {
+		return -1;
+	}
+
+	int enable = 1;
+	setsockopt(q->fds[0], IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+	setsockopt(q->fds[1], IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+	return 0;
+}
+
+static int ipc_udp_init(ipc_queue_t *q)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof(addr);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+
+	q->fds[0] = socket(AF_INET, SOCK_DGRAM, 0);
+	q->fds[1] = socket(AF_INET, SOCK_DGRAM, 0);
+	if (q->fds[0] == -1 || q->fds[1] == -1) {
+		return -1;
+	}
+	if (bind(q->fds[0], (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+		getsockname(q->fds[0], (struct sockaddr *)&addr, &addr_len) != 0 ||
+		connect(q->fds[1], (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		return -1;
+	}
+
+	// udp may drop datagrams when receive buffer is full
+	int buf_size = 4 * 1024 * 1024;
+	setsockopt(q->fds[0], SOL_SOCKET, SO_RCVBUF, &buf_size, sizeof(buf_size));
+	return ipc_socket_timeout(q->fds[0]);
+}
+
+int ipc_queue_init(ipc_queue_t *q, int32_t transport)
+{
+	memset(q, 0, sizeof(*q));
+	q->transport = transport;
+	q->fds[0] = -1;
+	q->fds[1] = -1;
+
+	int ret = 0;
+	switch (transport) {
+	case TRANSPORT_SHM: {
+		const char *k_name = "/dev/shm/benchmark_c2c_benchmark";
+		const int k_num = 6;
+		if (!muggle_path_exists(k_name)) {
+			FILE *fp = muggle_os_fopen(k_name, "w");
+			if (fp == NULL) {
+				LOG_ERROR("failed open k_name: %s", k_name);
+				return -1;
+			}
+			fclose(fp);
+		}
+		q->shm_rbuf = muggle_shm_ringbuf_open(
+			&q->shm, k_name, k_num, MUGGLE_SHM_FLAG_CREAT, 4 * 1024 * 1024);
+		ret = q->shm_rbuf == NULL ? -1 : 0;
+	} break;
+	case TRANSPORT_SPSC:
+	case TRANSPORT_FUTEX: {
+		ret = c2c_benchmark_spsc_init(&q->spsc, 1024 * 16,
+									  sizeof(cache_line_data_t));
+	} break;
+	case TRANSPORT_EVENTFD: {
+		ret = c2c_benchmark_spsc_init(&q->spsc, 1024 * 16,
+									  sizeof(cache_line_data_t));
+		if (ret == 0) {
+			q->fds[0] = eventfd(0, 0);
+			q->fds[1] = q->fds[0];
+			ret = q->fds[0] == -1 ? -1 : 0;
+		}
+	} break;
+	case TRANSPORT_PIPE: {
+		ret = pipe(q->fds);
+	} break;
+	case TRANSPORT_UDS_STREAM: {
+		ret = socketpair(AF_UNIX, SOCK_STREAM, 0, q->fds);
+	} break;
+	case TRANSPORT_UDS_DGRAM: {
+		ret = socketpair(AF_UNIX, SOCK_DGRAM, 0, q->fds);
+	} break;
+	case TRANSPORT_TCP: {
+		ret = ipc_tcp_init(q);
+	} break;
+	case TRANSPORT_UDP: {
+		ret = ipc_udp_init(q);
+	} break;
+	default: {
+		ret = -1;
+	} break;
+	}
+
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(errno, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed init transport %s, err=%s",
+				  s_transport_names[transport], errmsg);
+	}
+	return ret;
+}
+
+void ipc_queue_destroy(ipc_queue_t *q)
+{
+	switch (q->transport) {
+	case TRANSPORT_SHM: {
+		if (q->shm_rbuf) {
+			muggle_shm_detach(&q->shm);
+			muggle_shm_rm(&q->shm);
+		}
+	} break;
+	case TRANSPORT_SPSC:
+	case TRANSPORT_FUTEX:
+	case TRANSPORT_EVENTFD: {
+		c2c_benchmark_spsc_destroy(&q->spsc);
+	} break;
+	default: {
+	} break;
+	}
+
+	if (q->fds[0] != -1) {
+		close(q->fds[0]);
+	}
+	if (q->fds[1] != -1 && q->fds[1] != q->fds[0]) {
+		close(q->fds[1]);
+	}
+}
+
+static int ipc_write_all(int fd, const void *buf, size_t n)
+{
+	const char *p = (const char *)buf;
+	while (n > 0) {
+		ssize_t ret = write(fd, p, n);
+		if (ret < 0) {
+			if (errno == EINTR || errno == EAGAIN || errno == ENOBUFS) {
+				continue;
+			}
+			return -1;
+		}
+		p += ret;
+		n -= (size_t)ret;
+	}
+	return 0;
+}
+
+static int ipc_read_all(int fd, void *buf, size_t n)
+{
+	char *p = (char *)buf;
+	while (n > 0) {
+		ssize_t ret = read(fd, p, n);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		if (ret == 0) {
+			return -1;
+		}
+		p += ret;
+		n -= (size_t)ret;
+	}
+	return 0;
+}
+
+/**
+ * @brief start time counter of message and send it
+ */
+void ipc_queue_write(ipc_queue_t *q, cache_line_data_t *msg)
+{
+	switch (q->transport) {
+	case TRANSPORT_SHM: {
+		cache_line_data_t *ptr = NULL;
+		while ((ptr = (cache_line_data_t *)muggle_shm_ringbuf_w_alloc_bytes(
+					q->shm_rbuf, sizeof(cache_line_data_t))) == NULL)
+			;
+		muggle_time_counter_init(&ptr->tc);
+		muggle_time_counter_start(&ptr->tc);
+		muggle_shm_ringbuf_w_move(q->shm_rbuf);
+	} break;
+	case TRANSPORT_SPSC:
+	case TRANSPORT_EVENTFD:
+	case TRANSPORT_FUTEX: {
+		cache_line_data_t *ptr = NULL;
+		while ((ptr = (cache_line_data_t *)c2c_benchmark_spsc_w_alloc(
+					&q->spsc)) == NULL)
+			;
+		muggle_time_counter_init(&ptr->tc);
+		muggle_time_counter_start(&ptr->tc);
+		c2c_benchmark_spsc_w_move(&q->spsc);
+
+		if (q->transport == TRANSPORT_EVENTFD) {
+			uint64_t one = 1;
+			ipc_write_all(q->fds[1], &one, sizeof(one));
+		} else if (q->transport == TRANSPORT_FUTEX) {
+			muggle_atomic_fetch_add(&q->futex_word, 1,
+									muggle_memory_order_release);
+			syscall(SYS_futex, &q->futex_word, FUTEX_WAKE_PRIVATE, 1, NULL,
+					NULL, 0);
+		}
+	} break;
+	default: {
+		muggle_time_counter_init(&msg->tc);
+		muggle_time_counter_start(&msg->tc);
+		if (ipc_write_all(q->fds[1], msg, sizeof(*msg)) != 0) {
+			LOG_ERROR("failed write %s", s_transport_names[q->transport]);
+		}
+	} break;
+	}
+}
+
+/**
+ * @brief drain available spsc slots into datas and end their time counters
+ */
+static size_t ipc_spsc_drain(ipc_queue_t *q, cache_line_data_t *datas,
+							 size_t max_n)
+{
+	uint32_t n_avail = c2c_benchmark_spsc_r_available(&q->spsc);
+	if (n_avail > max_n) {
+		n_avail = (uint32_t)max_n;
+	}
+	for (uint32_t i = 0; i < n_avail; ++i) {
+		cache_line_data_t *ptr =
+			(cache_line_data_t *)c2c_benchmark_spsc_r_slot(&q->spsc, i);
+		datas[i].tc.start_ts = ptr->tc.start_ts;
+		muggle_time_counter_end(&datas[i].tc);
+	}
+	c2c_benchmark_spsc_r_move(&q->spsc, n_avail);
+	return n_avail;
+}
+
+/**
+ * @brief receive at least one message, end its time counter
+ *
+ * @return number of messages received, 0 on timeout or error
+ */
+size_t ipc_queue_read(ipc_queue_t *q, cache_line_data_t *datas, size_t max_n)
+{
+	switch (q->transport) {
+	case TRANSPORT_SHM: {
+		cache_line_data_t *ptr = NULL;
+		uint32_t n_bytes = 0;
+		while ((ptr = (cache_line_data_t *)muggle_shm_ringbuf_r_fetch(
+					q->shm_rbuf, &n_bytes)) == NULL)
+			;
+		datas[0].tc.start_ts = ptr->tc.start_ts;
+		muggle_time_counter_end(&datas[0].tc);
+		muggle_shm_ringbuf_r_move(q->shm_rbuf);
+		return 1;
+	} break;
+	case TRANSPORT_SPSC: {
+		size_t n = 0;
+		while ((n = ipc_spsc_drain(q, datas, max_n)) == 0)
+			;
+		return n;
+	} break;
+	case TRANSPORT_EVENTFD: {
+		while (1) {
+			uint64_t cnt = 0;
+			if (ipc_read_all(q->fds[0], &cnt, sizeof(cnt)) != 0) {
+				return 0;
+			}
+			size_t n = ipc_spsc_drain(q, datas, max_n);
+			if (n > 0) {
+				return n;
+			}
+		}
+	} break;
+	case TRANSPORT_FUTEX: {
+		while (1) {
+			int seen =
+				muggle_atomic_load(&q->futex_word, muggle_memory_order_acquire);
+			size_t n = ipc_spsc_drain(q, datas, max_n);
+			if (n > 0) {
+				return n;
+			}
+			// returns immediately if producer published after seen
+			syscall(SYS_futex, &q->futex_word, FUTEX_WAIT_PRIVATE, seen, NULL,
+					NULL, 0);
+		}
+	} break;
+	case TRANSPORT_UDS_DGRAM:
+	case TRANSPORT_UDP: {
+		ssize_t ret = 0;
+		do {
+			ret = recv(q->fds[0], &datas[0], sizeof(datas[0]), 0);
+		} while (ret < 0 && errno == EINTR);
+		if (ret != (ssize_t)sizeof(datas[0])) {
+			return 0;
+		}
+		muggle_time_counter_end(&datas[0].tc);
+		return 1;
+	} break;
+	default: {
+		if (ipc_read_all(q->fds[0], &datas[0], sizeof(datas[0])) != 0) {
+			return 0;
+		}
+		muggle_time_counter_end(&datas[0].tc);
+		return 1;
+	} break;
+	}
+}
+
+muggle_thread_ret_t proc_consumer(void *p)
+{
+	thread_args_t *p_args = (thread_args_t *)p;
+	args_t *args = p_args->sys_args;
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(args->consumer_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed consumer bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("consumer bind CPU core #%d", args->consumer_core);
+	}
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// run consumer
+	LOG_INFO("run consumer");
+	size_t total_cnt = p_args->total_cnt;
+	size_t n = 0;
+	while (n < total_cnt) {
+		size_t n_recv =
+			ipc_queue_read(p_args->q, p_args->datas + n, total_cnt - n);
+		if (n_recv == 0) {
+			LOG_WARNING("consumer stop after receive %llu/%llu messages",
+						(unsigned long long)n, (unsigned long long)total_cnt);
+			break;
+		}
+		n += n_recv;
+		if (p_args->paced) {
+			muggle_atomic_store(&p_args->q->n_acked, (int)n,
+								muggle_memory_order_release);
+		}
+	}
+	p_args->n_recv = n;
+	if (p_args->paced && n < total_cnt) {
+		muggle_atomic_store(&p_args->q->n_acked, -1,
+							muggle_memory_order_release);
+	}
+	LOG_INFO("consumer completed");
+
+	return 0;
+}
+
+void proc_producer(thread_args_t *p_args)
+{
+	args_t *args = p_args->sys_args;
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(args->producer_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed producer bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("producer bind CPU core #%d", args->producer_core);
+	}
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// run producer
+	LOG_INFO("run producer");
+	cache_line_data_t msg;
+	memset(&msg, 0, sizeof(msg));
+	if (p_args->paced) {
+		// one message in flight, ack wait is outside of the time counter
+		for (int i = 0; i < (int)p_args->total_cnt; ++i) {
+			ipc_queue_write(p_args->q, &msg);
+
+			int acked = 0;
+			do {
+				acked = muggle_atomic_load(&p_args->q->n_acked,
+										   muggle_memory_order_acquire);
+			} while (acked <= i && acked != -1);
+			if (acked == -1) {
+				break;
+			}
+
+			c2c_benchmark_wait_ns(args->round_interval_ns);
+		}
+		LOG_INFO("producer completed");
+		return;
+	}
+
+	for (int r = 0; r < args->rounds; ++r) {
+		for (int i = 0; i < args->record_per_round; ++i) {
+			ipc_queue_write(p_args->q, &msg);
+		}
+
+		c2c_benchmark_wait_ns(args->round_interval_ns);
+	}
+	LOG_INFO("producer completed");
+}
+
+/**
+ * @brief run one phase of transport
+ *
+ * @param paced  1 for paced latency phase, fill latency percentiles and
+ *               n_lost; 0 for burst phase, fill throughput, burst_p50 and
+ *               burst_lost
+ */
+int run_ipc(args_t *args, int32_t transport, int32_t paced,
+			result_t *result)
+{
+	// prepare datas
+	size_t total_cnt = (size_t)args->rounds;
+	if (!paced) {
+		total_cnt *= (size_t)args->record_per_round;
+	}
+	cache_line_data_t *datas =
+		(cache_line_data_t *)malloc(sizeof(cache_line_data_t) * total_cnt);
+	if (datas == NULL) {
+		return -1;
+	}
+
+	// init transport, spsc ring in queue needs cache line alignment
+	void *q_mem = malloc(sizeof(ipc_queue_t) + 64);
+	if (q_mem == NULL) {
+		free(datas);
+		return -1;
+	}
+	ipc_queue_t *q = (ipc_queue_t *)(((uintptr_t)q_mem + 63) & ~(uintptr_t)63);
+	if (ipc_queue_init(q, transport) != 0) {
+		ipc_queue_destroy(q);
+		free(q_mem);
+		free(datas);
+		return -1;
+	}
+
+	thread_args_t th_args;
+	th_args.sys_args = args;
+	th_args.q = q;
+	th_args.paced = paced;
+	th_args.total_cnt = total_cnt;
+	th_args.datas = datas;
+	th_args.n_recv = 0;
+
+	// run consumer
+	muggle_thread_t th_consumer;
+	muggle_thread_create(&th_consumer, proc_consumer, &th_args);
+
+	// run producer
+	LOG_INFO("wait consumer run");
+	muggle_msleep(5);
+	proc_producer(&th_args);
+
+	// cleanup thread
+	muggle_thread_join(&th_consumer);
+
+	// cleanup transport
+	ipc_queue_destroy(q);
+	free(q_mem);
+
+	// output report
+	size_t n_recv = th_args.n_recv;
+	if (n_recv > 0) {
+		char name[128];
+		snprintf(name, sizeof(name), "ipc_%s%s%s",
+				 s_transport_names[transport], paced ? "" : "_burst",
+				 args->noisy ? "_noise" : "");
+		int64_t p50 = c2c_benchmark_gen_report(name, args->producer_core,
+											   args->consumer_core, datas,
+											   n_recv, 0);
+		if (paced) {
+			result->p50 = p50;
+			result->p90 = c2c_benchmark_percentile(datas, n_recv, 90.0);
+			result->p99 = c2c_benchmark_percentile(datas, n_recv, 99.0);
+			result->max = c2c_benchmark_percentile(datas, n_recv, 100.0);
+		} else {
+			result->burst_p50 = p50;
+			result->throughput = c2c_benchmark_throughput(datas, n_recv);
+		}
+	}
+	if (paced) {
+		result->n_recv = n_recv;
+		result->n_lost = total_cnt - n_recv;
+	} else {
+		result->burst_lost = total_cnt - n_recv;
+	}
+
+	free(datas);
+	return n_recv > 0 ? 0 : -1;
+}
+
+/**
+ * @brief run every transport, quiet or under noise
+ */
+void run_transports(void *p, int32_t noisy)
+{
+	run_t *run = (run_t *)p;
+	args_t *args = run->args;
+	result_t *results = run->results[noisy];
+	int32_t *succeed = run->succeed[noisy];
+
+	args->noisy = noisy;
+	for (int32_t i = 0; i < args->n_transport; ++i) {
+		memset(&results[i], 0, sizeof(results[i]));
+		succeed[i] = run_ipc(args, args->transports[i], 1, &results[i]) == 0;
+		if (succeed[i]) {
+			run_ipc(args, args->transports[i], 0, &results[i]);
+		}
+	}
+	args->noisy = 0;
+}
+
+/**
+ * @brief print table and summary of transports, with delta of paced
+ * latency under noise against quiet run if noisy
+ */
+void report_transports(args_t *args, run_t *run, int noisy)
+{
+	char summary_filepath[MUGGLE_MAX_PATH];
+	snprintf(summary_filepath, sizeof(summary_filepath),
+			 "./c2c_benchmark_reports/summary_ipc_c%d_to_c%d.csv",
+			 args->producer_core, args->consumer_core);
+	FILE *fp = muggle_os_fopen(summary_filepath, "w");
+	if (fp) {
+		fprintf(fp, "transport,p50,p90,p99,max,throughput,burst_p50,lost,"
+					"burst_lost");
+		c2c_benchmark_noise_csv_head(fp, noisy);
+		fprintf(fp, "\n");
+	}
+
+	// p50 to max and lost are from paced phase, msg/s, burst p50 and b_lost
+	// from burst; msg/s with '*' only counts messages consumer got
+	fprintf(stdout, "%12s%10s%10s%10s%12s%15s%12s%8s%8s", "transport", "p50",
+			"p90", "p99", "max", "msg/s", "burst_p50", "lost", "b_lost");
+	c2c_benchmark_noise_print_head(stdout, noisy);
+	fprintf(stdout, "\n");
+	for (int32_t i = 0; i < args->n_transport; ++i) {
+		const char *name = s_transport_names[args->transports[i]];
+		if (!run->succeed[0][i]) {
+			fprintf(stdout, "%12s%10s\n", name, "failed");
+			continue;
+		}
+		result_t *result = &run->results[0][i];
+		result_t *noise_result = &run->results[1][i];
+		int64_t noise_p50 = run->succeed[1][i] ? noise_result->p50 : -1;
+		fprintf(stdout, "%12s%10lld%10lld%10lld%12lld%14.0f%1s%12lld%8llu%8llu",
+				name, (long long)result->p50, (long long)result->p90,
+				(long long)result->p99, (long long)result->max,
+				result->throughput, result->burst_lost > 0 ? "*" : "",
+				(long long)result->burst_p50,
+				(unsigned long long)result->n_lost,
+				(unsigned long long)result->burst_lost);
+		c2c_benchmark_noise_print_delta(stdout, noisy, result->p50,
+										result->p99, noise_p50,
+										noise_result->p99);
+		fprintf(stdout, "\n");
+		if (fp) {
+			fprintf(fp, "%s,%lld,%lld,%lld,%lld,%.0f,%lld,%llu,%llu", name,
+					(long long)result->p50, (long long)result->p90,
+					(long long)result->p99, (long long)result->max,
+					result->throughput, (long long)result->burst_p50,
+					(unsigned long long)result->n_lost,
+					(unsigned long long)result->burst_lost);
+			c2c_benchmark_noise_csv_delta(fp, noisy, result->p50,
+										  result->p99, noise_p50,
+										  noise_result->p99);
+			fprintf(fp, "\n");
+		}
+	}
+
+	if (fp) {
+		fclose(fp);
+		LOG_INFO("generate summary report: %s", summary_filepath);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	// initialize log
+	if (muggle_log_complicated_init(MUGGLE_LOG_LEVEL_INFO,
+									MUGGLE_LOG_LEVEL_INFO,
+									"logs/c2c_benchmark_ipc.log") != 0) {
+		fprintf(stderr, "failed init log\n");
+		exit(EXIT_FAILURE);
+	}
+
+	args_t args;
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
+	LOG_INFO("----------------");
+	LOG_INFO("rounds: %d", args.rounds);
+	LOG_INFO("record_per_round: %d", args.record_per_round);
+	LOG_INFO("round_interval_ns: %d", args.round_interval_ns);
+	LOG_INFO("producer_core: %d", args.producer_core);
+	LOG_INFO("consumer_core: %d", args.consumer_core);
+	for (int32_t i = 0; i < args.n_transport; ++i) {
+		LOG_INFO("transport[%d]: %s", i,
+				 s_transport_names[args.transports[i]]);
+	}
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
+	LOG_INFO("----------------");
+
+	if (args.producer_core == -1 || args.consumer_core == -1) {
+		LOG_ERROR("run without producer or consumer core");
+		exit(EXIT_FAILURE);
+	}
+
+	int32_t cores[2] = { args.producer_core, args.consumer_core };
+	c2c_benchmark_preflight("ipc", cores, 2);
+
+	run_t *run = (run_t *)malloc(sizeof(run_t));
+	if (run == NULL) {
+		LOG_ERROR("failed allocate results");
+		exit(EXIT_FAILURE);
+	}
+	memset(run, 0, sizeof(*run));
+	run->args = &args;
+	int noisy =
+		c2c_benchmark_noise_run(&noise_args, cores, 2, run_transports, run);
+	if (noise_args.n_spec > 0 && !noisy) {
+		fprintf(stdout, "noise skipped\n");
+	}
+	report_transports(&args, run, noisy);
+	free(run);
+
+	return 0;
+}
+
+#else
+
+int main()
+{
+	fprintf(stderr, "c2c_benchmark_ipc only supports linux\n");
+	return EXIT_FAILURE;
+}
+
+#endif
@@ -0,0 +1,571 @@
+#include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+	defined(_M_IX86)
+	#include <emmintrin.h>
+	#define LINE_FLUSH_X86 1
+#elif defined(__aarch64__)
+	#define LINE_FLUSH_ARM64 1
+#endif
+
+#define MAX_N_HELPER 16
+
+#define LINE_STATE_M 0
+#define LINE_STATE_E 1
+#define LINE_STATE_S 2
+#define LINE_STATE_L3 3
+#define LINE_STATE_DRAM 4
+#define LINE_STATE_MAX 5
+#define LINE_STATE_STOP 7
+
+// command: seq in high bits, state in low 3 bits
+#define LINE_CMD(seq, state) ((seq) * 8 + (state))
+#define LINE_CMD_SEQ(cmd) ((cmd) / 8)
+#define LINE_CMD_STATE(cmd) ((cmd) % 8)
+
+#define LINE_OP_READ 0
+#define LINE_OP_WRITE 1
+
+static const char *s_state_names[LINE_STATE_MAX] = { "M", "E", "S", "L3",
+													 "DRAM" };
+
+typedef struct {
+	int32_t owner_core;
+	int32_t measured_core;
+	int32_t n_helper;
+	int32_t helper_cores[MAX_N_HELPER];
+	int32_t total_cnt;
+	int32_t evict_bytes;
+	int32_t noisy;
+} args_t;
+
+typedef union {
+	MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+	muggle_atomic_int v;
+} padded_atomic_int_t;
+
+// adjacent line prefetcher fetches lines in 128 bytes aligned pairs
+typedef union {
+	char pair[128];
+	muggle_atomic_int v;
+} pair_padded_atomic_int_t;
+
+typedef struct {
+	// target owns its line pair, with a whole pair of padding on each
+	// side, so accessing cmd or acks never pulls target in
+	char pad_head[128];
+	pair_padded_atomic_int_t target;
+	char pad_tail[128];
+	padded_atomic_int_t cmd;
+	padded_atomic_int_t acks[MAX_N_HELPER + 1];
+} shared_t;
+
+typedef struct {
+	int32_t idx; //!< 0 is owner, otherwise helper idx + 1
+	int32_t core;
+	args_t *sys_args;
+	shared_t *shared;
+} thread_args_t;
+
+typedef struct {
+	int64_t p50[LINE_STATE_MAX * 2]; //!< [state * 2 + op], INT64_MIN if skipped
+	int64_t p99[LINE_STATE_MAX * 2];
+} pair_result_t;
+
+typedef struct {
+	args_t *args;
+	pair_result_t results[2]; //!< [noisy]
+} pair_t;
+
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
+{
+	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
+	args->owner_core = -1;
+	args->measured_core = -1;
+	args->n_helper = 0;
+	args->total_cnt = 10000;
+	args->evict_bytes = 4 * 1024 * 1024;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:c:H:n:e:N:R:Lh")) != -1) {
+		switch (opt) {
+		case 'p': {
+			args->owner_core = atoi(optarg);
+		} break;
+		case 'c': {
+			args->measured_core = atoi(optarg);
+		} break;
+		case 'H': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				args->helper_cores[args->n_helper++] = atoi(token);
+				token = strtok(NULL, ",");
+				if (args->n_helper >= MAX_N_HELPER) {
+					break;
+				}
+			}
+		} break;
+		case 'n': {
+			args->total_cnt = atoi(optarg);
+		} break;
+		case 'e': {
+			args->evict_bytes = atoi(optarg);
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
+		case 'h': {
+			printf("Usage of %s:\n"
+				   "  -p int\n"
+				   "    owner bind core, prepare line state before sample\n"
+				   "  -c int\n"
+				   "    measured bind core, access the line\n"
+				   "  -H int array split with comma\n"
+				   "    helper bind cores, share the line in 'S' state,\n"
+				   "    excluded from sweep\n"
+				   "  -n int\n"
+				   "    samples per state\n"
+				   "  -e int\n"
+				   "    bytes owner reads to evict line from private caches "
+				   "in 'L3' state\n"
+				   "\n"
+				   "states:\n"
+				   "  M    owner modified\n"
+				   "  E    owner read, exclusive\n"
+				   "  S    owner and helpers read, shared\n"
+				   "  L3   owner modified, then evicted from private caches\n"
+				   "  DRAM flushed from all caches\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   "    with noise, each pair runs quiet, then again under\n"
+				   "    noise; noise never runs on owner, measured or helper\n"
+				   "    cores, rows of noise p50 and delta of p50/p99\n"
+				   "    against quiet follow the quiet row\n"
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
+				   "\n"
+				   "e.g.\n"
+				   "  %s -p 0 -c 1 -H 2,3\n"
+				   "",
+				   argv[0], argv[0]);
+			exit(EXIT_SUCCESS);
+		} break;
+		}
+	}
+}
+
+static void flush_line(void *p)
+{
+#if LINE_FLUSH_X86
+	_mm_clflush(p);
+	_mm_mfence();
+#elif LINE_FLUSH_ARM64
+	__asm__ volatile("dc civac, %0" ::"r"(p) : "memory");
+	__asm__ volatile("dsb ish" ::: "memory");
+#else
+	(void)p;
+#endif
+}
+
+static void evict_private_caches(volatile char *buf, int32_t n_bytes)
+{
+	for (int32_t i = 0; i < n_bytes; i += 64) {
+		(void)buf[i];
+	}
+}
+
+static int is_helper_core(args_t *args, int32_t core)
+{
+	for (int32_t h = 0; h < args->n_helper; ++h) {
+		if (args->helper_cores[h] == core) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void bind_core(const char *role, int32_t core)
+{
+	int ret = c2c_benchmark_bind_core(core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed %s bind CPU core, err=%s", role, errmsg);
+	} else {
+		LOG_INFO("%s bind CPU core #%d", role, core);
+	}
+}
+
+muggle_thread_ret_t proc_prepare(void *p)
+{
+	thread_args_t *p_args = (thread_args_t *)p;
+	args_t *args = p_args->sys_args;
+	shared_t *shared = p_args->shared;
+	muggle_atomic_int *ack = &shared->acks[p_args->idx].v;
+	volatile muggle_atomic_int *target = &shared->target.v;
+
+	bind_core(p_args->idx == 0 ? "owner" : "helper", p_args->core);
+
+	volatile char *evict_buf = NULL;
+	if (p_args->idx == 0) {
+		evict_buf = (volatile char *)malloc(args->evict_bytes);
+		if (evict_buf) {
+			memset((void *)evict_buf, 0, args->evict_bytes);
+		}
+	}
+
+	c2c_benchmark_warmup(2);
+
+	muggle_atomic_store(ack, 0, muggle_memory_order_release);
+
+	int32_t seq = 0;
+	while (1) {
+		int32_t cmd = 0;
+		do {
+			cmd = muggle_atomic_load(&shared->cmd.v,
+									 muggle_memory_order_acquire);
+		} while (LINE_CMD_SEQ(cmd) == seq);
+		seq = LINE_CMD_SEQ(cmd);
+		int32_t state = LINE_CMD_STATE(cmd);
+		if (state == LINE_STATE_STOP) {
+			break;
+		}
+
+		if (p_args->idx == 0) {
+			switch (state) {
+			case LINE_STATE_M: {
+				*target = seq;
+			} break;
+			case LINE_STATE_E:
+			case LINE_STATE_S: {
+				(void)*target;
+			} break;
+			case LINE_STATE_L3: {
+				*target = seq;
+				if (evict_buf) {
+					evict_private_caches(evict_buf, args->evict_bytes);
+				}
+			} break;
+			case LINE_STATE_DRAM: {
+				*target = seq;
+				flush_line((void *)target);
+			} break;
+			}
+		} else if (state == LINE_STATE_S) {
+			// wait owner load line first, then share it
+			while (muggle_atomic_load(&shared->acks[0].v,
+									  muggle_memory_order_acquire) < seq)
+				;
+			(void)*target;
+		}
+
+		muggle_atomic_store(ack, seq, muggle_memory_order_release);
+	}
+
+	free((void *)evict_buf);
+
+	return 0;
+}
+
+/**
+ * @brief measure access latency of the line in given state
+ *
+ * @param p99  output p99 of access elapsed, without timer overhead
+ *
+ * @return middle value of access elapsed, without timer overhead
+ */
+int64_t run_state(args_t *args, shared_t *shared, int32_t *seq,
+				  int32_t state, int32_t op, cache_line_data_t *datas,
+				  int64_t overhead, int64_t *p99)
+{
+	volatile muggle_atomic_int *target = &shared->target.v;
+	int32_t n_prepare = state == LINE_STATE_S ? args->n_helper + 1 : 1;
+
+	for (int32_t i = 0; i < args->total_cnt; ++i) {
+		// make sure measured core does not hold the line
+		flush_line((void *)target);
+
+		++(*seq);
+		muggle_atomic_store(&shared->cmd.v, LINE_CMD(*seq, state),
+							muggle_memory_order_release);
+		for (int32_t h = 0; h < n_prepare; ++h) {
+			while (muggle_atomic_load(&shared->acks[h].v,
+									  muggle_memory_order_acquire) < *seq)
+				;
+		}
+
+		if (op == LINE_OP_READ) {
+			muggle_time_counter_start(&datas[i].tc);
+			(void)*target;
+			muggle_time_counter_end(&datas[i].tc);
+		} else {
+			// seq_cst store waits for ownership of the line
+			muggle_time_counter_start(&datas[i].tc);
+			muggle_atomic_store((muggle_atomic_int *)target, -(*seq),
+								muggle_memory_order_seq_cst);
+			muggle_time_counter_end(&datas[i].tc);
+		}
+	}
+
+	char name[128];
+	snprintf(name, sizeof(name), "line_state_%s_%s%s", s_state_names[state],
+			 op == LINE_OP_READ ? "read" : "write",
+			 args->noisy ? "_noise" : "");
+	int64_t middle_val =
+		c2c_benchmark_gen_report(name, args->owner_core, args->measured_core,
+								 datas, args->total_cnt, 0);
+	*p99 = c2c_benchmark_percentile(datas, args->total_cnt, 99.0) - overhead;
+	return middle_val - overhead;
+}
+
+/**
+ * @brief measure every state and op for one core pair
+ *
+ * @param result  output
+ */
+void run_line_state(args_t *args, pair_result_t *result)
+{
+	for (int32_t i = 0; i < LINE_STATE_MAX * 2; ++i) {
+		result->p50[i] = INT64_MIN;
+		result->p99[i] = INT64_MIN;
+	}
+
+	shared_t *shared = (shared_t *)malloc(sizeof(shared_t) + 4096);
+	cache_line_data_t *datas = (cache_line_data_t *)malloc(
+		sizeof(cache_line_data_t) * args->total_cnt);
+	if (shared == NULL || datas == NULL) {
+		LOG_ERROR("failed allocate datas");
+		free(shared);
+		free(datas);
+		return;
+	}
+	void *mem = shared;
+	shared = (shared_t *)(((uintptr_t)mem + 4095) & ~(uintptr_t)4095);
+	memset(shared, 0, sizeof(*shared));
+	for (int32_t h = 0; h < args->n_helper + 1; ++h) {
+		shared->acks[h].v = -1;
+	}
+
+	// run owner and helpers
+	thread_args_t th_args[MAX_N_HELPER + 1];
+	muggle_thread_t threads[MAX_N_HELPER + 1];
+	for (int32_t h = 0; h < args->n_helper + 1; ++h) {
+		th_args[h].idx = h;
+		th_args[h].core =
+			h == 0 ? args->owner_core : args->helper_cores[h - 1];
+		th_args[h].sys_args = args;
+		th_args[h].shared = shared;
+		muggle_thread_create(&threads[h], proc_prepare, &th_args[h]);
+	}
+
+	bind_core("measured", args->measured_core);
+	c2c_benchmark_warmup(2);
+	for (int32_t h = 0; h < args->n_helper + 1; ++h) {
+		while (muggle_atomic_load(&shared->acks[h].v,
+								  muggle_memory_order_acquire) != 0)
+			;
+	}
+
+	// timer overhead
+	for (int32_t i = 0; i < args->total_cnt; ++i) {
+		muggle_time_counter_start(&datas[i].tc);
+		muggle_time_counter_end(&datas[i].tc);
+	}
+	int64_t overhead = c2c_benchmark_gen_report(
+		args->noisy ? "line_state_overhead_noise" : "line_state_overhead",
+		args->owner_core, args->measured_core, datas, args->total_cnt, 0);
+	LOG_INFO("timer overhead: %lld ns", (long long)overhead);
+
+	int32_t seq = 0;
+	for (int32_t state = 0; state < LINE_STATE_MAX; ++state) {
+		for (int32_t op = 0; op < 2; ++op) {
+			if (state == LINE_STATE_S && args->n_helper == 0) {
+				continue;
+			}
+			int32_t idx = state * 2 + op;
+			result->p50[idx] = run_state(args, shared, &seq, state, op,
+										 datas, overhead, &result->p99[idx]);
+		}
+	}
+
+	// stop owner and helpers
+	muggle_atomic_store(&shared->cmd.v, LINE_CMD(seq + 1, LINE_STATE_STOP),
+						muggle_memory_order_release);
+	for (int32_t h = 0; h < args->n_helper + 1; ++h) {
+		muggle_thread_join(&threads[h]);
+	}
+
+	free(datas);
+	free(mem);
+}
+
+/**
+ * @brief measure every state and op, quiet or under noise
+ */
+void run_pair_noise(void *p, int32_t noisy)
+{
+	pair_t *pair = (pair_t *)p;
+	pair->args->noisy = noisy;
+	run_line_state(pair->args, &pair->results[noisy]);
+	pair->args->noisy = 0;
+}
+
+static void print_results_head(FILE *fp)
+{
+	fprintf(fp, "%6s%6s", "owner", "meas");
+	for (int32_t state = 0; state < LINE_STATE_MAX; ++state) {
+		char buf[16];
+		snprintf(buf, sizeof(buf), "%s_r", s_state_names[state]);
+		fprintf(fp, "%8s", buf);
+		snprintf(buf, sizeof(buf), "%s_w", s_state_names[state]);
+		fprintf(fp, "%8s", buf);
+	}
+	fprintf(fp, "\n");
+}
+
+static void print_results(FILE *fp, args_t *args, const int64_t *results,
+						  const char *tag)
+{
+	fprintf(fp, "%6d%6d", args->owner_core, args->measured_core);
+	for (int32_t i = 0; i < LINE_STATE_MAX * 2; ++i) {
+		if (results[i] == INT64_MIN) {
+			fprintf(fp, "%8s", "-");
+		} else {
+			fprintf(fp, "%8lld", (long long)results[i]);
+		}
+	}
+	fprintf(fp, "%s\n", tag);
+}
+
+/**
+ * @brief run one pair and print its row; under noise, also print noise p50
+ * and delta of p50/p99 against quiet
+ */
+static void run_pair(args_t *args, c2c_benchmark_noise_args_t *noise_args)
+{
+	pair_t pair;
+	memset(&pair, 0, sizeof(pair));
+	pair.args = args;
+
+	int32_t measured_cores[2 + MAX_N_HELPER];
+	measured_cores[0] = args->owner_core;
+	measured_cores[1] = args->measured_core;
+	memcpy(measured_cores + 2, args->helper_cores,
+		   sizeof(int32_t) * args->n_helper);
+	int noisy = c2c_benchmark_noise_run(noise_args, measured_cores,
+										2 + args->n_helper, run_pair_noise,
+										&pair);
+	pair_result_t *quiet = &pair.results[0];
+	pair_result_t *noise = &pair.results[1];
+	if (noise_args->n_spec == 0) {
+		print_results(stdout, args, quiet->p50, "");
+		return;
+	}
+
+	print_results(stdout, args, quiet->p50, "  quiet");
+	if (!noisy) {
+		fprintf(stdout, "%6d%6d  noise skipped\n", args->owner_core,
+				args->measured_core);
+		return;
+	}
+
+	int64_t d_p50[LINE_STATE_MAX * 2];
+	int64_t d_p99[LINE_STATE_MAX * 2];
+	for (int32_t i = 0; i < LINE_STATE_MAX * 2; ++i) {
+		if (quiet->p50[i] == INT64_MIN || noise->p50[i] == INT64_MIN) {
+			d_p50[i] = INT64_MIN;
+			d_p99[i] = INT64_MIN;
+		} else {
+			d_p50[i] = noise->p50[i] - quiet->p50[i];
+			d_p99[i] = noise->p99[i] - quiet->p99[i];
+		}
+	}
+	print_results(stdout, args, noise->p50, "  noise");
+	print_results(stdout, args, d_p50, "  d_p50");
+	print_results(stdout, args, d_p99, "  d_p99");
+}
+
+int main(int argc, char *argv[])
+{
+	// initialize log
+	if (muggle_log_complicated_init(MUGGLE_LOG_LEVEL_INFO,
+									MUGGLE_LOG_LEVEL_INFO,
+									"logs/c2c_benchmark_line_state.log") != 0) {
+		fprintf(stderr, "failed init log\n");
+		exit(EXIT_FAILURE);
+	}
+
+	args_t args;
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
+	LOG_INFO("----------------");
+	LOG_INFO("owner_core: %d", args.owner_core);
+	LOG_INFO("measured_core: %d", args.measured_core);
+	LOG_INFO("n_helper: %d", args.n_helper);
+	for (int32_t i = 0; i < args.n_helper; ++i) {
+		LOG_INFO("helper_core[%d]: %d", i, args.helper_cores[i]);
+	}
+	LOG_INFO("total_cnt: %d", args.total_cnt);
+	LOG_INFO("evict_bytes: %d", args.evict_bytes);
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
+	LOG_INFO("----------------");
+
+	if (args.owner_core == -1 || args.measured_core == -1) {
+		c2c_benchmark_preflight("line_state", NULL, 0);
+	} else {
+		int32_t cores[2 + MAX_N_HELPER];
+		cores[0] = args.owner_core;
+		cores[1] = args.measured_core;
+		memcpy(cores + 2, args.helper_cores, sizeof(int32_t) * args.n_helper);
+		c2c_benchmark_preflight("line_state", cores, 2 + args.n_helper);
+	}
+
+#if !LINE_FLUSH_X86 && !LINE_FLUSH_ARM64
+	LOG_WARNING("cache line flush is not supported on this platform, "
+				"'DRAM' state is not accurate");
+#endif
+	if (args.n_helper == 0) {
+		LOG_WARNING("run without helper cores, skip 'S' state");
+	}
+
+	if (args.owner_core == -1 || args.measured_core == -1) {
+		long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+		if (num_cores == -1) {
+			LOG_ERROR("failed get core numbers: %d", MUGGLE_EVENT_LAST_ERRNO);
+			exit(EXIT_FAILURE);
+		}
+
+		// helpers keep spinning on their cores, skip pairs on them
+		print_results_head(stdout);
+		for (int i = 0; i < num_cores; ++i) {
+			if (is_helper_core(&args, i)) {
+				continue;
+			}
+			for (int j = i + 1; j < num_cores; ++j) {
+				if (is_helper_core(&args, j)) {
+					continue;
+				}
+				args.owner_core = i;
+				args.measured_core = j;
+				run_pair(&args, &noise_args);
+				fflush(stdout);
+			}
+		}
+	} else {
+		print_results_head(stdout);
+		run_pair(&args, &noise_args);
+	}
+
+	return 0;
+}
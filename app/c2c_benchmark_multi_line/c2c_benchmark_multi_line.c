@@ -0,0 +1,479 @@
+#include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+
+#define MAX_N_LINE_CNT 32
+
+#define ORDER_SEQ 0
+#define ORDER_STRIDE 1
+#define ORDER_RAND 2
+
+typedef struct {
+	int32_t producer_core;
+	int32_t consumer_core;
+	int32_t total_cnt;
+	int32_t order;
+	int32_t stride;
+	int32_t n_line_cnt;
+	int32_t line_cnts[MAX_N_LINE_CNT];
+	int32_t noisy;
+} args_t;
+
+typedef struct {
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+		struct {
+			args_t *sys_args;
+			char *lines;
+			int32_t *order;
+			int32_t n_lines;
+		};
+	};
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(1);
+		muggle_atomic_int v1;
+	};
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(2);
+		muggle_atomic_int v2;
+	};
+} shared_t;
+
+typedef struct {
+	int64_t p50; //!< -1 if failed
+	int64_t p99;
+} row_t;
+
+typedef struct {
+	args_t *args;
+	row_t rows[2][MAX_N_LINE_CNT + 1]; //!< [noisy][0 is baseline, k + 1]
+} sweep_t;
+
+static const char *order_name(int32_t order)
+{
+	switch (order) {
+	case ORDER_STRIDE:
+		return "stride";
+	case ORDER_RAND:
+		return "rand";
+	default:
+		return "seq";
+	}
+}
+
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
+{
+	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
+	args->producer_core = -1;
+	args->consumer_core = -1;
+	args->total_cnt = 10000;
+	args->order = ORDER_SEQ;
+	args->stride = 4;
+	args->n_line_cnt = 0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:c:n:k:o:d:N:R:Lh")) != -1) {
+		switch (opt) {
+		case 'p': {
+			args->producer_core = atoi(optarg);
+		} break;
+		case 'c': {
+			args->consumer_core = atoi(optarg);
+		} break;
+		case 'n': {
+			args->total_cnt = atoi(optarg);
+		} break;
+		case 'k': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				int32_t k = atoi(token);
+				if (k > 0) {
+					args->line_cnts[args->n_line_cnt++] = k;
+				}
+				token = strtok(NULL, ",");
+				if (args->n_line_cnt >= MAX_N_LINE_CNT) {
+					break;
+				}
+			}
+		} break;
+		case 'o': {
+			if (strcmp(optarg, "seq") == 0) {
+				args->order = ORDER_SEQ;
+			} else if (strcmp(optarg, "stride") == 0) {
+				args->order = ORDER_STRIDE;
+			} else if (strcmp(optarg, "rand") == 0) {
+				args->order = ORDER_RAND;
+			} else {
+				LOG_ERROR("invalid order");
+			}
+		} break;
+		case 'd': {
+			args->stride = atoi(optarg);
+			if (args->stride < 1) {
+				args->stride = 1;
+			}
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
+		case 'h': {
+			printf("Usage of %s:\n"
+				   "  -p int\n"
+				   "    producer bind core\n"
+				   "  -c int\n"
+				   "    consumer bind core\n"
+				   "  -n int\n"
+				   "    total count\n"
+				   "  -k int array split with comma\n"
+				   "    number of cache lines per message, default: "
+				   "1,2,4,8,16,32,64,128\n"
+				   "  -o string\n"
+				   "    write/read order of lines; 'seq', 'stride' or 'rand'\n"
+				   "  -d int\n"
+				   "    distance between lines in 'stride' order (cache\n"
+				   "    lines)\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   "    with noise, the sweep runs quiet, then again under\n"
+				   "    noise; p50/p99 under noise and their delta against\n"
+				   "    quiet are added to each line count\n"
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
+				   "\n"
+				   "e.g.\n"
+				   "  %s -p 0 -c 1 -k 1,4,16,64 -o stride -d 2\n"
+				   "",
+				   argv[0], argv[0]);
+			exit(EXIT_SUCCESS);
+		} break;
+		}
+	}
+
+	if (args->n_line_cnt == 0) {
+		for (int32_t k = 1; k <= 128; k *= 2) {
+			args->line_cnts[args->n_line_cnt++] = k;
+		}
+	}
+}
+
+muggle_thread_ret_t proc_consumer(void *p)
+{
+	shared_t *shared = (shared_t *)p;
+	args_t *args = shared->sys_args;
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(args->consumer_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed consumer bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("consumer bind CPU core #%d", args->consumer_core);
+	}
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// run consumer: wait flag, read every word of all lines, then ack
+	uint64_t sum = 0;
+	for (int32_t i = 0; i < args->total_cnt; ++i) {
+		while (muggle_atomic_load(&shared->v1, muggle_memory_order_acquire) !=
+			   i)
+			;
+		for (int32_t k = 0; k < shared->n_lines; ++k) {
+			volatile uint64_t *line =
+				(volatile uint64_t *)(shared->lines +
+									  (size_t)shared->order[k] * 64);
+			for (int w = 0; w < 8; ++w) {
+				sum += line[w];
+			}
+		}
+		muggle_atomic_store(&shared->v2, i, muggle_memory_order_release);
+	}
+
+	uint64_t expect = 0;
+	for (int32_t i = 0; i < args->total_cnt; ++i) {
+		expect += (uint64_t)i * 8 * shared->n_lines;
+	}
+	if (sum != expect) {
+		LOG_ERROR("consumer read unexpected data: %llu != %llu",
+				  (unsigned long long)sum, (unsigned long long)expect);
+	}
+
+	return 0;
+}
+
+void proc_producer(shared_t *shared, cache_line_data_t *datas)
+{
+	args_t *args = shared->sys_args;
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(args->producer_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed producer bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("producer bind CPU core #%d", args->producer_core);
+	}
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// run producer: write all lines, publish flag, wait consumer ack
+	for (int32_t i = 0; i < args->total_cnt; ++i) {
+		muggle_time_counter_start(&datas[i].tc);
+		for (int32_t k = 0; k < shared->n_lines; ++k) {
+			volatile uint64_t *line =
+				(volatile uint64_t *)(shared->lines +
+									  (size_t)shared->order[k] * 64);
+			for (int w = 0; w < 8; ++w) {
+				line[w] = (uint64_t)i;
+			}
+		}
+		muggle_atomic_store(&shared->v1, i, muggle_memory_order_release);
+		while (muggle_atomic_load(&shared->v2, muggle_memory_order_acquire) !=
+			   i)
+			;
+		muggle_time_counter_end(&datas[i].tc);
+	}
+}
+
+void gen_order(args_t *args, int32_t *order, int32_t n_lines)
+{
+	for (int32_t k = 0; k < n_lines; ++k) {
+		order[k] = args->order == ORDER_STRIDE ? k * args->stride : k;
+	}
+
+	if (args->order == ORDER_RAND) {
+		// fixed seed, every run visit lines in the same order
+		srand(n_lines);
+		for (int32_t k = n_lines - 1; k > 0; --k) {
+			int32_t j = rand() % (k + 1);
+			int32_t tmp = order[k];
+			order[k] = order[j];
+			order[j] = tmp;
+		}
+	}
+}
+
+void run_multi_line(args_t *args, int32_t n_lines, row_t *row)
+{
+	row->p50 = -1;
+	row->p99 = -1;
+
+	// prepare lines, aligned to page
+	size_t n_slots = (size_t)(n_lines > 0 ? n_lines : 1);
+	if (args->order == ORDER_STRIDE) {
+		n_slots *= (size_t)args->stride;
+	}
+	char *mem = (char *)malloc(n_slots * 64 + 4096);
+	if (mem == NULL) {
+		return;
+	}
+	char *lines = (char *)(((uintptr_t)mem + 4095) & ~(uintptr_t)4095);
+	memset(lines, 0, n_slots * 64);
+
+	int32_t *order = (int32_t *)malloc(sizeof(int32_t) * n_slots);
+	if (order == NULL) {
+		free(mem);
+		return;
+	}
+	gen_order(args, order, n_lines);
+
+	cache_line_data_t *datas = (cache_line_data_t *)malloc(
+		sizeof(cache_line_data_t) * args->total_cnt);
+	if (datas == NULL) {
+		free(order);
+		free(mem);
+		return;
+	}
+	for (int32_t i = 0; i < args->total_cnt; ++i) {
+		muggle_time_counter_init(&datas[i].tc);
+	}
+
+	shared_t shared;
+	memset(&shared, 0, sizeof(shared));
+	shared.sys_args = args;
+	shared.lines = lines;
+	shared.order = order;
+	shared.n_lines = n_lines;
+	shared.v1 = -1;
+	shared.v2 = -1;
+
+	// run consumer
+	muggle_thread_t th_consumer;
+	muggle_thread_create(&th_consumer, proc_consumer, &shared);
+
+	// run producer
+	proc_producer(&shared, datas);
+
+	// cleanup consumer
+	muggle_thread_join(&th_consumer);
+
+	char name[128];
+	snprintf(name, sizeof(name), "multi_line_%s_k%d%s",
+			 order_name(args->order), n_lines, args->noisy ? "_noise" : "");
+	row->p50 =
+		c2c_benchmark_gen_report(name, args->producer_core, args->consumer_core,
+								 datas, args->total_cnt, 0);
+	row->p99 = c2c_benchmark_percentile(datas, args->total_cnt, 99.0);
+
+	free(datas);
+	free(order);
+	free(mem);
+}
+
+/**
+ * @brief run baseline and every line count, quiet or under noise
+ */
+void run_sweep(void *p, int32_t noisy)
+{
+	sweep_t *sweep = (sweep_t *)p;
+	args_t *args = sweep->args;
+	row_t *rows = sweep->rows[noisy];
+
+	args->noisy = noisy;
+	run_multi_line(args, 0, &rows[0]);
+	for (int32_t i = 0; i < args->n_line_cnt; ++i) {
+		run_multi_line(args, args->line_cnts[i], &rows[i + 1]);
+	}
+	args->noisy = 0;
+}
+
+/**
+ * @brief print table and summary of sweep, with delta of noise run against
+ * quiet run if noisy
+ */
+void report_sweep(args_t *args, sweep_t *sweep, int noisy)
+{
+	row_t *rows = sweep->rows[0];
+	row_t *noise_rows = sweep->rows[1];
+	int64_t base_val = rows[0].p50;
+	if (base_val < 0) {
+		LOG_ERROR("failed run baseline");
+		return;
+	}
+
+	char summary_filepath[MUGGLE_MAX_PATH];
+	snprintf(summary_filepath, sizeof(summary_filepath),
+			 "./c2c_benchmark_reports/summary_multi_line_%s_c%d_to_c%d.csv",
+			 order_name(args->order), args->producer_core,
+			 args->consumer_core);
+	FILE *fp = muggle_os_fopen(summary_filepath, "w");
+	if (fp) {
+		fprintf(fp, "lines,rtt_ns,per_line_ns,bandwidth_gbps");
+		c2c_benchmark_noise_csv_head(fp, noisy);
+		fprintf(fp, "\n0,%lld,0,0", (long long)base_val);
+		c2c_benchmark_noise_csv_delta(fp, noisy, rows[0].p50, rows[0].p99,
+									  noise_rows[0].p50, noise_rows[0].p99);
+		fprintf(fp, "\n");
+	}
+
+	fprintf(stdout, "%d -> %d, order: %s, baseline rtt: %lld ns",
+			args->producer_core, args->consumer_core, order_name(args->order),
+			(long long)base_val);
+	if (noisy && noise_rows[0].p50 >= 0) {
+		fprintf(stdout, ", noise %lld ns, delta %lld",
+				(long long)noise_rows[0].p50,
+				(long long)(noise_rows[0].p50 - base_val));
+	}
+	fprintf(stdout, "\n");
+	fprintf(stdout, "%8s%12s%14s%18s", "lines", "rtt(ns)", "per_line(ns)",
+			"bandwidth(GB/s)");
+	c2c_benchmark_noise_print_head(stdout, noisy);
+	fprintf(stdout, "\n");
+	for (int32_t i = 0; i < args->n_line_cnt; ++i) {
+		int32_t n_lines = args->line_cnts[i];
+		row_t *row = &rows[i + 1];
+		row_t *noise_row = &noise_rows[i + 1];
+		if (row->p50 < 0) {
+			LOG_ERROR("failed run with %d lines", n_lines);
+			continue;
+		}
+
+		// amortized cost of payload: rtt above the bare flag handoff
+		int64_t payload_val = row->p50 - base_val;
+		double per_line = (double)payload_val / n_lines;
+		double bandwidth =
+			payload_val > 0 ? (double)n_lines * 64 / payload_val : 0.0;
+		fprintf(stdout, "%8d%12lld%14.2f%18.2f", n_lines, (long long)row->p50,
+				per_line, bandwidth);
+		c2c_benchmark_noise_print_delta(stdout, noisy, row->p50, row->p99,
+										noise_row->p50, noise_row->p99);
+		fprintf(stdout, "\n");
+		if (fp) {
+			fprintf(fp, "%d,%lld,%.2f,%.2f", n_lines, (long long)row->p50,
+					per_line, bandwidth);
+			c2c_benchmark_noise_csv_delta(fp, noisy, row->p50, row->p99,
+										  noise_row->p50, noise_row->p99);
+			fprintf(fp, "\n");
+		}
+	}
+
+	if (fp) {
+		fclose(fp);
+		LOG_INFO("generate summary report: %s", summary_filepath);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	// initialize log
+	if (muggle_log_complicated_init(MUGGLE_LOG_LEVEL_INFO,
+									MUGGLE_LOG_LEVEL_INFO,
+									"logs/c2c_benchmark_multi_line.log") != 0) {
+		fprintf(stderr, "failed init log\n");
+		exit(EXIT_FAILURE);
+	}
+
+	args_t args;
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
+	LOG_INFO("----------------");
+	LOG_INFO("producer_core: %d", args.producer_core);
+	LOG_INFO("consumer_core: %d", args.consumer_core);
+	LOG_INFO("total_cnt: %d", args.total_cnt);
+	LOG_INFO("order: %s", order_name(args.order));
+	LOG_INFO("stride: %d", args.stride);
+	for (int32_t i = 0; i < args.n_line_cnt; ++i) {
+		LOG_INFO("line_cnts[%d]: %d", i, args.line_cnts[i]);
+	}
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
+	LOG_INFO("----------------");
+
+	if (args.producer_core == -1 || args.consumer_core == -1) {
+		LOG_ERROR("run without producer or consumer core");
+		exit(EXIT_FAILURE);
+	}
+
+	int32_t cores[2] = { args.producer_core, args.consumer_core };
+	c2c_benchmark_preflight("multi_line", cores, 2);
+
+	sweep_t *sweep = (sweep_t *)malloc(sizeof(sweep_t));
+	if (sweep == NULL) {
+		LOG_ERROR("failed allocate sweep");
+		exit(EXIT_FAILURE);
+	}
+	memset(sweep, 0, sizeof(*sweep));
+	sweep->args = &args;
+	int noisy =
+		c2c_benchmark_noise_run(&noise_args, cores, 2, run_sweep, sweep);
+	if (noise_args.n_spec > 0 && !noisy) {
+		fprintf(stdout, "noise skipped\n");
+	}
+	report_sweep(&args, sweep, noisy);
+	free(sweep);
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,569 @@
+#include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+#include "c2c_benchmark_spsc.h"
+
+#define MAX_N_STAGE 16
+
+#define TRANSPORT_CHAN 0
+#define TRANSPORT_SHM 1
+#define TRANSPORT_SPSC 2
+
+typedef struct {
+	int32_t rounds;
+	int32_t record_per_round;
+	int32_t round_interval_ns;
+	int32_t n_core;
+	int32_t cores[MAX_N_STAGE + 1];
+	int32_t transport;
+	int32_t noisy;
+} args_t;
+
+typedef union {
+	char placeholder[64];
+	struct {
+		int32_t idx;
+	};
+} msg_t;
+
+typedef struct {
+	int32_t transport;
+	muggle_channel_t chan;
+	muggle_shm_t shm;
+	muggle_shm_ringbuf_t *shm_rbuf;
+	c2c_benchmark_spsc_t spsc;
+} hop_queue_t;
+
+typedef struct {
+	int32_t stage;
+	args_t *sys_args;
+	hop_queue_t *in;
+	hop_queue_t *out;
+	msg_t *msgs;
+	struct timespec *ts;
+} thread_args_t;
+
+typedef struct {
+	int64_t p50; //!< -1 if failed
+	int64_t p90;
+	int64_t p99;
+	int64_t max;
+} row_t;
+
+typedef struct {
+	args_t *args;
+	row_t rows[2][MAX_N_STAGE + 1]; //!< [noisy][hop - 1], last is e2e
+} run_t;
+
+static const char *transport_name(int32_t transport)
+{
+	switch (transport) {
+	case TRANSPORT_SHM:
+		return "shm";
+	case TRANSPORT_SPSC:
+		return "spsc";
+	default:
+		return "chan";
+	}
+}
+
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
+{
+	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
+	args->rounds = 1000;
+	args->record_per_round = 1;
+	args->round_interval_ns = 1000;
+	args->n_core = 0;
+	args->transport = TRANSPORT_SPSC;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "r:m:i:c:t:N:R:Lh")) != -1) {
+		switch (opt) {
+		case 'r': {
+			args->rounds = atoi(optarg);
+		} break;
+		case 'm': {
+			args->record_per_round = atoi(optarg);
+		} break;
+		case 'i': {
+			args->round_interval_ns = atoi(optarg);
+		} break;
+		case 'c': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				args->cores[args->n_core++] = atoi(token);
+				token = strtok(NULL, ",");
+				if (args->n_core >= MAX_N_STAGE + 1) {
+					break;
+				}
+			}
+		} break;
+		case 't': {
+			if (strcmp(optarg, "chan") == 0) {
+				args->transport = TRANSPORT_CHAN;
+			} else if (strcmp(optarg, "shm") == 0) {
+				args->transport = TRANSPORT_SHM;
+			} else if (strcmp(optarg, "spsc") == 0) {
+				args->transport = TRANSPORT_SPSC;
+			} else {
+				LOG_ERROR("invalid transport");
+			}
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
+		case 'h': {
+			printf("Usage of %s:\n"
+				   "  -r int\n"
+				   "    rounds\n"
+				   "  -m int\n"
+				   "    record per round\n"
+				   "  -i int\n"
+				   "    round interval (nanoseconds)\n"
+				   "  -c int array split with comma\n"
+				   "    stage bind cores; first is source, last is sink\n"
+				   "  -t string\n"
+				   "    transport between stages; 'chan', 'shm' or 'spsc'\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   "    with noise, the pipeline runs quiet, then again\n"
+				   "    under noise; noise never runs on stage cores, p50/p99\n"
+				   "    under noise and their delta against quiet are added\n"
+				   "    to each hop\n"
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
+				   "\n"
+				   "e.g.\n"
+				   "  %s -c 0,1,2,3 -t spsc\n"
+				   "",
+				   argv[0], argv[0]);
+			exit(EXIT_SUCCESS);
+		} break;
+		}
+	}
+}
+
+int hop_queue_init(hop_queue_t *q, int32_t transport, int32_t hop)
+{
+	memset(q, 0, sizeof(*q));
+	q->transport = transport;
+
+	switch (transport) {
+	case TRANSPORT_CHAN: {
+		int flags =
+			MUGGLE_CHANNEL_FLAG_WRITE_SPIN | MUGGLE_CHANNEL_FLAG_READ_BUSY;
+		if (muggle_channel_init(&q->chan, 1024 * 16, flags) != 0) {
+			LOG_ERROR("failed init channel");
+			return -1;
+		}
+	} break;
+	case TRANSPORT_SHM: {
+		const char *k_name = "/dev/shm/benchmark_c2c_benchmark";
+		const int k_num = 16 + hop;
+#if MUGGLE_PLATFORM_WINDOWS
+#else
+		if (!muggle_path_exists(k_name)) {
+			FILE *fp = muggle_os_fopen(k_name, "w");
+			if (fp == NULL) {
+				LOG_ERROR("failed open k_name: %s", k_name);
+				return -1;
+			}
+			fclose(fp);
+		}
+#endif
+		q->shm_rbuf = muggle_shm_ringbuf_open(
+			&q->shm, k_name, k_num, MUGGLE_SHM_FLAG_CREAT, 4 * 1024 * 1024);
+		if (q->shm_rbuf == NULL) {
+			LOG_ERROR("failed create shm_ringbuf");
+			return -1;
+		}
+	} break;
+	default: {
+		if (c2c_benchmark_spsc_init(&q->spsc, 1024 * 16, sizeof(msg_t)) !=
+			0) {
+			LOG_ERROR("failed init spsc ring");
+			return -1;
+		}
+	} break;
+	}
+
+	return 0;
+}
+
+void hop_queue_destroy(hop_queue_t *q)
+{
+	switch (q->transport) {
+	case TRANSPORT_CHAN: {
+		muggle_channel_destroy(&q->chan);
+	} break;
+	case TRANSPORT_SHM: {
+		muggle_shm_detach(&q->shm);
+		muggle_shm_rm(&q->shm);
+	} break;
+	default: {
+		c2c_benchmark_spsc_destroy(&q->spsc);
+	} break;
+	}
+}
+
+/**
+ * @brief forward message, spin until success
+ */
+void hop_queue_write(hop_queue_t *q, msg_t *msg)
+{
+	switch (q->transport) {
+	case TRANSPORT_CHAN: {
+		while (muggle_channel_write(&q->chan, msg) != 0)
+			;
+	} break;
+	case TRANSPORT_SHM: {
+		void *ptr = NULL;
+		while ((ptr = muggle_shm_ringbuf_w_alloc_bytes(q->shm_rbuf,
+													   sizeof(msg_t))) == NULL)
+			;
+		memcpy(ptr, msg, sizeof(msg_t));
+		muggle_shm_ringbuf_w_move(q->shm_rbuf);
+	} break;
+	default: {
+		void *ptr = NULL;
+		while ((ptr = c2c_benchmark_spsc_w_alloc(&q->spsc)) == NULL)
+			;
+		memcpy(ptr, msg, sizeof(msg_t));
+		c2c_benchmark_spsc_w_move(&q->spsc);
+	} break;
+	}
+}
+
+/**
+ * @brief receive message, spin until success
+ *
+ * @return message; for copy transports, it is buf
+ */
+msg_t *hop_queue_read(hop_queue_t *q, msg_t *buf)
+{
+	switch (q->transport) {
+	case TRANSPORT_CHAN: {
+		msg_t *msg = NULL;
+		while ((msg = (msg_t *)muggle_channel_read(&q->chan)) == NULL)
+			;
+		return msg;
+	} break;
+	case TRANSPORT_SHM: {
+		void *ptr = NULL;
+		uint32_t n_bytes = 0;
+		while ((ptr = muggle_shm_ringbuf_r_fetch(q->shm_rbuf, &n_bytes)) ==
+			   NULL)
+			;
+		memcpy(buf, ptr, sizeof(msg_t));
+		muggle_shm_ringbuf_r_move(q->shm_rbuf);
+		return buf;
+	} break;
+	default: {
+		while (c2c_benchmark_spsc_r_available(&q->spsc) == 0)
+			;
+		memcpy(buf, c2c_benchmark_spsc_r_slot(&q->spsc, 0), sizeof(msg_t));
+		c2c_benchmark_spsc_r_move(&q->spsc, 1);
+		return buf;
+	} break;
+	}
+}
+
+static void bind_stage_core(int32_t stage, int32_t core)
+{
+	int ret = c2c_benchmark_bind_core(core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed stage %d bind CPU core, err=%s", stage, errmsg);
+	} else {
+		LOG_INFO("stage %d bind CPU core #%d", stage, core);
+	}
+}
+
+muggle_thread_ret_t proc_stage(void *p)
+{
+	thread_args_t *p_args = (thread_args_t *)p;
+	args_t *args = p_args->sys_args;
+	size_t total_cnt = (size_t)args->rounds * (size_t)args->record_per_round;
+
+	bind_stage_core(p_args->stage, args->cores[p_args->stage]);
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// receive, timestamp and forward to next stage
+	LOG_INFO("run stage %d", p_args->stage);
+	muggle_time_counter_t tc;
+	msg_t buf;
+	for (size_t n = 0; n < total_cnt; ++n) {
+		msg_t *msg = hop_queue_read(p_args->in, &buf);
+		muggle_time_counter_start(&tc);
+		p_args->ts[msg->idx] = tc.start_ts;
+		if (p_args->out) {
+			hop_queue_write(p_args->out, msg);
+		}
+	}
+	LOG_INFO("stage %d completed", p_args->stage);
+
+	return 0;
+}
+
+void proc_source(thread_args_t *p_args)
+{
+	args_t *args = p_args->sys_args;
+
+	bind_stage_core(0, args->cores[0]);
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// run source
+	LOG_INFO("run source");
+	muggle_time_counter_t tc;
+	int32_t idx = 0;
+	for (int r = 0; r < args->rounds; ++r) {
+		for (int i = 0; i < args->record_per_round; ++i) {
+			msg_t *msg = &p_args->msgs[idx];
+			msg->idx = idx;
+			muggle_time_counter_start(&tc);
+			p_args->ts[idx] = tc.start_ts;
+			hop_queue_write(p_args->out, msg);
+			++idx;
+		}
+
+		c2c_benchmark_wait_ns(args->round_interval_ns);
+	}
+	LOG_INFO("source completed");
+}
+
+static void set_row(row_t *row, cache_line_data_t *datas, size_t total_cnt,
+					int64_t middle_val)
+{
+	row->p50 = middle_val;
+	row->p90 = c2c_benchmark_percentile(datas, total_cnt, 90);
+	row->p99 = c2c_benchmark_percentile(datas, total_cnt, 99);
+	row->max = c2c_benchmark_percentile(datas, total_cnt, 100);
+}
+
+static void print_row(const char *title, row_t *row, int noisy,
+					  row_t *noise_row)
+{
+	fprintf(stdout, "%-16s%10lld%10lld%10lld%10lld", title,
+			(long long)row->p50, (long long)row->p90, (long long)row->p99,
+			(long long)row->max);
+	c2c_benchmark_noise_print_delta(stdout, noisy, row->p50, row->p99,
+									noise_row->p50, noise_row->p99);
+	fprintf(stdout, "\n");
+}
+
+/**
+ * @brief run pipeline, rows[hop - 1] of each hop and rows[n_hop] of end to
+ * end
+ */
+void run_pipeline(args_t *args, row_t *rows)
+{
+	for (int32_t s = 0; s < args->n_core; ++s) {
+		rows[s].p50 = -1;
+	}
+
+	int32_t n_hop = args->n_core - 1;
+	size_t total_cnt = (size_t)args->rounds * (size_t)args->record_per_round;
+
+	// prepare datas
+	msg_t *msgs = (msg_t *)malloc(sizeof(msg_t) * total_cnt);
+	struct timespec *ts =
+		(struct timespec *)malloc(sizeof(struct timespec) * total_cnt *
+								  args->n_core);
+	cache_line_data_t *datas =
+		(cache_line_data_t *)malloc(sizeof(cache_line_data_t) * total_cnt);
+	// spsc ring in queue needs cache line alignment
+	void *queues_mem = malloc(sizeof(hop_queue_t) * n_hop + 64);
+	hop_queue_t *queues =
+		(hop_queue_t *)(((uintptr_t)queues_mem + 63) & ~(uintptr_t)63);
+	if (msgs == NULL || ts == NULL || datas == NULL || queues_mem == NULL) {
+		LOG_ERROR("failed allocate datas");
+		free(msgs);
+		free(ts);
+		free(datas);
+		free(queues_mem);
+		return;
+	}
+
+	// init queues
+	int32_t n_queue = 0;
+	for (; n_queue < n_hop; ++n_queue) {
+		if (hop_queue_init(&queues[n_queue], args->transport, n_queue) != 0) {
+			break;
+		}
+	}
+	if (n_queue != n_hop) {
+		for (int32_t i = 0; i < n_queue; ++i) {
+			hop_queue_destroy(&queues[i]);
+		}
+		free(msgs);
+		free(ts);
+		free(datas);
+		free(queues_mem);
+		return;
+	}
+
+	// run stages
+	thread_args_t th_args[MAX_N_STAGE + 1];
+	muggle_thread_t th_stage[MAX_N_STAGE + 1];
+	for (int32_t s = 0; s < args->n_core; ++s) {
+		th_args[s].stage = s;
+		th_args[s].sys_args = args;
+		th_args[s].in = s > 0 ? &queues[s - 1] : NULL;
+		th_args[s].out = s < n_hop ? &queues[s] : NULL;
+		th_args[s].msgs = msgs;
+		th_args[s].ts = ts + s * total_cnt;
+	}
+	for (int32_t s = 1; s < args->n_core; ++s) {
+		muggle_thread_create(&th_stage[s], proc_stage, &th_args[s]);
+	}
+
+	// run source
+	LOG_INFO("wait stages run");
+	muggle_msleep(5);
+	proc_source(&th_args[0]);
+
+	// cleanup stages
+	for (int32_t s = 1; s < args->n_core; ++s) {
+		muggle_thread_join(&th_stage[s]);
+	}
+	for (int32_t i = 0; i < n_hop; ++i) {
+		hop_queue_destroy(&queues[i]);
+	}
+
+	// output report
+	const char *transport = transport_name(args->transport);
+	const char *noise_suffix = args->noisy ? "_noise" : "";
+	char name[128];
+	for (int32_t s = 1; s < args->n_core; ++s) {
+		for (size_t i = 0; i < total_cnt; ++i) {
+			datas[i].tc.start_ts = ts[(s - 1) * total_cnt + i];
+			datas[i].tc.end_ts = ts[s * total_cnt + i];
+		}
+		snprintf(name, sizeof(name), "pipeline_%s_hop%d%s", transport, s,
+				 noise_suffix);
+		int64_t middle_val = c2c_benchmark_gen_report(
+			name, args->cores[s - 1], args->cores[s], datas, total_cnt, 0);
+		set_row(&rows[s - 1], datas, total_cnt, middle_val);
+	}
+
+	for (size_t i = 0; i < total_cnt; ++i) {
+		datas[i].tc.start_ts = ts[i];
+		datas[i].tc.end_ts = ts[n_hop * total_cnt + i];
+	}
+	char cores[256];
+	c2c_benchmark_core_list_str(args->cores, args->n_core, cores,
+								sizeof(cores));
+	snprintf(name, sizeof(name), "pipeline_%s_e2e%s", transport,
+			 noise_suffix);
+	int64_t middle_val = c2c_benchmark_gen_report_cores(
+		name, cores, cores, datas, total_cnt, 0);
+	set_row(&rows[n_hop], datas, total_cnt, middle_val);
+
+	// cleanup datas
+	free(msgs);
+	free(ts);
+	free(datas);
+	free(queues_mem);
+}
+
+/**
+ * @brief run pipeline, quiet or under noise
+ */
+void run_pipeline_noise(void *p, int32_t noisy)
+{
+	run_t *run = (run_t *)p;
+	run->args->noisy = noisy;
+	run_pipeline(run->args, run->rows[noisy]);
+	run->args->noisy = 0;
+}
+
+/**
+ * @brief print every hop and end to end, with delta of noise run against
+ * quiet run if noisy
+ */
+void report_pipeline(args_t *args, run_t *run, int noisy)
+{
+	row_t *rows = run->rows[0];
+	row_t *noise_rows = run->rows[1];
+	int32_t n_hop = args->n_core - 1;
+	if (rows[n_hop].p50 < 0) {
+		LOG_ERROR("failed run pipeline");
+		return;
+	}
+
+	fprintf(stdout, "%-16s%10s%10s%10s%10s", transport_name(args->transport),
+			"p50", "p90", "p99", "max");
+	c2c_benchmark_noise_print_head(stdout, noisy);
+	fprintf(stdout, "\n");
+	for (int32_t s = 1; s <= n_hop; ++s) {
+		char title[64];
+		snprintf(title, sizeof(title), "hop%d %d->%d", s, args->cores[s - 1],
+				 args->cores[s]);
+		print_row(title, &rows[s - 1], noisy, &noise_rows[s - 1]);
+	}
+	print_row("end-to-end", &rows[n_hop], noisy, &noise_rows[n_hop]);
+}
+
+int main(int argc, char *argv[])
+{
+	// initialize log
+	if (muggle_log_complicated_init(MUGGLE_LOG_LEVEL_INFO,
+									MUGGLE_LOG_LEVEL_INFO,
+									"logs/c2c_benchmark_pipeline.log") != 0) {
+		fprintf(stderr, "failed init log\n");
+		exit(EXIT_FAILURE);
+	}
+
+	args_t args;
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
+	LOG_INFO("----------------");
+	LOG_INFO("rounds: %d", args.rounds);
+	LOG_INFO("record_per_round: %d", args.record_per_round);
+	LOG_INFO("round_interval_ns: %d", args.round_interval_ns);
+	for (int32_t i = 0; i < args.n_core; ++i) {
+		LOG_INFO("stage_core[%d]: %d", i, args.cores[i]);
+	}
+	LOG_INFO("transport: %s", transport_name(args.transport));
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
+	LOG_INFO("----------------");
+
+	if (args.n_core < 2) {
+		LOG_ERROR("pipeline need at least source and sink cores");
+		exit(EXIT_FAILURE);
+	}
+
+	c2c_benchmark_preflight("pipeline", args.cores, args.n_core);
+
+	run_t *run = (run_t *)malloc(sizeof(run_t));
+	if (run == NULL) {
+		LOG_ERROR("failed allocate run");
+		exit(EXIT_FAILURE);
+	}
+	memset(run, 0, sizeof(*run));
+	run->args = &args;
+	int noisy = c2c_benchmark_noise_run(&noise_args, args.cores, args.n_core,
+										run_pipeline_noise, run);
+	if (noise_args.n_spec > 0 && !noisy) {
+		fprintf(stdout, "noise skipped\n");
+	}
+	report_pipeline(&args, run, noisy);
+	free(run);
+
+	return 0;
+}
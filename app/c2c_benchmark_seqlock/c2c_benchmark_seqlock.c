@@ -0,0 +1,660 @@
+#include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+
+#define MAX_N_READER 64
+#define MAX_N_LINE_CNT 32
+#define WORDS_PER_LINE (64 / sizeof(muggle_atomic_int))
+
+// retry histogram buckets: 0, 1, 2-3, 4-7, 8-15, 16+; a retry is a copy
+// that failed validation, waiting on odd seq is counted apart
+#define N_RETRY_BUCKET 6
+
+typedef struct {
+	int32_t writer_core;
+	int32_t n_reader;
+	int32_t reader_cores[MAX_N_READER];
+	int32_t total_cnt;
+	int32_t write_interval_ns;
+	int32_t sweep;
+	int32_t n_line_cnt;
+	int32_t line_cnts[MAX_N_LINE_CNT];
+	int32_t noisy;
+} args_t;
+
+typedef union {
+	MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+	muggle_atomic_int v;
+} padded_atomic_int_t;
+
+typedef struct {
+	args_t *sys_args;
+	int32_t n_reader;
+	int32_t n_lines;
+	muggle_atomic_int *words; //!< n_lines record, cache line aligned
+	padded_atomic_int_t seq; //!< odd while writer updates record
+	padded_atomic_int_t n_ready;
+	padded_atomic_int_t done;
+} shared_t;
+
+typedef struct {
+	int32_t idx;
+	shared_t *shared;
+	cache_line_data_t *datas;
+	int32_t n_snapshot;
+	uint64_t n_retry;
+	uint64_t n_torn;
+	uint64_t n_wait; //!< snapshots that waited for writer on odd seq
+	int64_t wait_ns; //!< total time waited on odd seq
+	uint64_t hist[N_RETRY_BUCKET];
+} thread_args_t;
+
+typedef struct {
+	int64_t p50; //!< -1 if reader got no snapshot
+	int64_t p99;
+	int32_t n_snapshot;
+	uint64_t n_retry;
+	uint64_t n_torn;
+	uint64_t n_wait;
+	int64_t wait_ns;
+	uint64_t hist[N_RETRY_BUCKET];
+} reader_result_t;
+
+typedef struct {
+	int32_t done; //!< 0 if run failed
+	int64_t write_val;
+	reader_result_t readers[MAX_N_READER];
+} row_t;
+
+typedef struct {
+	args_t *args;
+	row_t *rows[2]; //!< quiet and noise, n_line_cnt x n_reader rows each
+} sweep_t;
+
+static const char *s_bucket_names[N_RETRY_BUCKET] = { "0",	 "1",	 "2-3",
+													  "4-7", "8-15", "16+" };
+
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
+{
+	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
+	args->writer_core = -1;
+	args->n_reader = 0;
+	for (int i = 0; i < MAX_N_READER; ++i) {
+		args->reader_cores[i] = -1;
+	}
+	args->total_cnt = 10000;
+	args->write_interval_ns = 1000;
+	args->sweep = 0;
+	args->n_line_cnt = 0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:c:n:i:k:sN:R:Lh")) != -1) {
+		switch (opt) {
+		case 'p': {
+			args->writer_core = atoi(optarg);
+		} break;
+		case 'c': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				args->reader_cores[args->n_reader++] = atoi(token);
+				token = strtok(NULL, ",");
+				if (args->n_reader >= MAX_N_READER) {
+					break;
+				}
+			}
+		} break;
+		case 'n': {
+			args->total_cnt = atoi(optarg);
+		} break;
+		case 'i': {
+			args->write_interval_ns = atoi(optarg);
+		} break;
+		case 'k': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				int32_t k = atoi(token);
+				if (k > 0) {
+					args->line_cnts[args->n_line_cnt++] = k;
+				}
+				token = strtok(NULL, ",");
+				if (args->n_line_cnt >= MAX_N_LINE_CNT) {
+					break;
+				}
+			}
+		} break;
+		case 's': {
+			args->sweep = 1;
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
+		case 'h': {
+			printf("Usage of %s:\n"
+				   "  -p int\n"
+				   "    writer bind core\n"
+				   "  -c int array split with comma\n"
+				   "    reader bind cores\n"
+				   "  -n int\n"
+				   "    number of record updates\n"
+				   "  -i int\n"
+				   "    interval between record updates (nanoseconds)\n"
+				   "  -k int array split with comma\n"
+				   "    number of cache lines in record, default 1,2,4,8,16\n"
+				   "  -s\n"
+				   "    sweep number of readers, from 1 to all reader cores\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   "    with noise, the sweep runs quiet, then again under\n"
+				   "    noise; noise never runs on any reader core, and\n"
+				   "    p50/p99 under noise and their delta against quiet\n"
+				   "    are added to each row\n"
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
+				   "\n"
+				   "e.g.\n"
+				   "  %s -p 0 -c 1,2,3 -k 1,4,16 -s\n"
+				   "",
+				   argv[0], argv[0]);
+			exit(EXIT_SUCCESS);
+		} break;
+		}
+	}
+
+	if (args->n_line_cnt == 0) {
+		for (int32_t k = 1; k <= 16; k *= 2) {
+			args->line_cnts[args->n_line_cnt++] = k;
+		}
+	}
+}
+
+static int retry_bucket(uint32_t n_retry)
+{
+	int b = 0;
+	while (n_retry > 0 && b < N_RETRY_BUCKET - 1) {
+		n_retry >>= 1;
+		++b;
+	}
+	return b;
+}
+
+muggle_thread_ret_t proc_reader(void *p)
+{
+	thread_args_t *p_args = (thread_args_t *)p;
+	shared_t *shared = p_args->shared;
+	args_t *args = shared->sys_args;
+	int32_t bind_core = args->reader_cores[p_args->idx];
+	cache_line_data_t *datas = p_args->datas;
+	size_t n_words = (size_t)shared->n_lines * WORDS_PER_LINE;
+
+	int32_t *snapshot = (int32_t *)malloc(sizeof(int32_t) * n_words);
+	if (snapshot == NULL) {
+		LOG_ERROR("failed allocate snapshot");
+		muggle_atomic_fetch_add(&shared->n_ready.v, 1,
+								muggle_memory_order_release);
+		return 0;
+	}
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(bind_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed reader bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("reader bind CPU core #%d", bind_core);
+	}
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// notify writer ready
+	muggle_atomic_fetch_add(&shared->n_ready.v, 1, muggle_memory_order_release);
+
+	// run reader: poll for a new or in progress version, then take a
+	// consistent snapshot; latency is from the first attempt to the
+	// validated copy
+	int32_t last_version = -1;
+	while (p_args->n_snapshot < args->total_cnt) {
+		int done = muggle_atomic_load(&shared->done.v,
+									  muggle_memory_order_acquire);
+		int s1 = muggle_atomic_load(&shared->seq.v,
+									muggle_memory_order_acquire);
+		if ((s1 & 1) == 0 && s1 / 2 - 1 == last_version) {
+			if (done) {
+				break;
+			}
+			continue;
+		}
+
+		muggle_time_counter_t *tc = &datas[p_args->n_snapshot].tc;
+		muggle_time_counter_start(tc);
+		uint32_t n_retry = 0;
+		int waited = 0;
+		while (1) {
+			if (s1 & 1) {
+				// writer holds the record, waiting for it is not a retry
+				muggle_time_counter_t wait_tc;
+				muggle_time_counter_init(&wait_tc);
+				muggle_time_counter_start(&wait_tc);
+				do {
+					s1 = muggle_atomic_load(&shared->seq.v,
+											muggle_memory_order_acquire);
+				} while (s1 & 1);
+				muggle_time_counter_end(&wait_tc);
+				p_args->wait_ns += muggle_time_counter_interval_ns(&wait_tc);
+				waited = 1;
+			}
+
+			// acquire loads keep the second seq load after the data loads
+			for (size_t w = 0; w < n_words; ++w) {
+				snapshot[w] = muggle_atomic_load(&shared->words[w],
+												 muggle_memory_order_acquire);
+			}
+			int s2 =
+				muggle_atomic_load(&shared->seq.v, muggle_memory_order_acquire);
+			if (s2 == s1) {
+				break;
+			}
+			++n_retry;
+			s1 = s2;
+		}
+		p_args->n_wait += waited;
+		muggle_time_counter_end(tc);
+
+		last_version = snapshot[0];
+		for (size_t w = 1; w < n_words; ++w) {
+			if (snapshot[w] != last_version) {
+				++p_args->n_torn;
+				break;
+			}
+		}
+
+		++p_args->n_snapshot;
+		p_args->n_retry += n_retry;
+		++p_args->hist[retry_bucket(n_retry)];
+	}
+
+	if (p_args->n_torn > 0) {
+		LOG_ERROR("reader #%d got %llu torn snapshots", p_args->idx,
+				  (unsigned long long)p_args->n_torn);
+	}
+
+	free(snapshot);
+
+	return 0;
+}
+
+void proc_writer(shared_t *shared, cache_line_data_t *datas)
+{
+	args_t *args = shared->sys_args;
+	size_t n_words = (size_t)shared->n_lines * WORDS_PER_LINE;
+
+	// bind core
+	int ret = c2c_benchmark_bind_core(args->writer_core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed writer bind CPU core, err=%s", errmsg);
+	} else {
+		LOG_INFO("writer bind CPU core #%d", args->writer_core);
+	}
+
+	// warmup
+	c2c_benchmark_warmup(2);
+
+	// wait readers
+	while (muggle_atomic_load(&shared->n_ready.v,
+							  muggle_memory_order_acquire) != shared->n_reader)
+		;
+
+	// run writer
+	// NOTE: release data stores keep the odd seq visible before any data
+	// word, so a reader that sees new data also sees the odd seq after it
+	for (int32_t i = 0; i < args->total_cnt; ++i) {
+		if (args->write_interval_ns > 0) {
+			c2c_benchmark_wait_ns(args->write_interval_ns);
+		}
+
+		muggle_time_counter_start(&datas[i].tc);
+		muggle_atomic_store(&shared->seq.v, 2 * i + 1,
+							muggle_memory_order_relaxed);
+		for (size_t w = 0; w < n_words; ++w) {
+			muggle_atomic_store(&shared->words[w], i,
+								muggle_memory_order_release);
+		}
+		muggle_atomic_store(&shared->seq.v, 2 * i + 2,
+							muggle_memory_order_release);
+		muggle_time_counter_end(&datas[i].tc);
+	}
+
+	muggle_atomic_store(&shared->done.v, 1, muggle_memory_order_release);
+}
+
+void run_seqlock(args_t *args, int32_t n_lines, int32_t n_reader, row_t *row)
+{
+	// prepare record, aligned to page
+	size_t n_bytes = (size_t)n_lines * 64;
+	char *mem = (char *)malloc(n_bytes + 4096);
+	size_t total_cnt = (size_t)args->total_cnt;
+	cache_line_data_t *w_datas =
+		(cache_line_data_t *)malloc(sizeof(cache_line_data_t) * total_cnt);
+	cache_line_data_t *r_datas = (cache_line_data_t *)malloc(
+		sizeof(cache_line_data_t) * total_cnt * n_reader);
+	shared_t *shared = (shared_t *)malloc(sizeof(shared_t));
+	if (mem == NULL || w_datas == NULL || r_datas == NULL || shared == NULL) {
+		LOG_ERROR("failed allocate datas");
+		free(mem);
+		free(w_datas);
+		free(r_datas);
+		free(shared);
+		return;
+	}
+	for (size_t i = 0; i < total_cnt; ++i) {
+		muggle_time_counter_init(&w_datas[i].tc);
+	}
+	for (size_t i = 0; i < total_cnt * n_reader; ++i) {
+		muggle_time_counter_init(&r_datas[i].tc);
+	}
+
+	memset(shared, 0, sizeof(*shared));
+	shared->sys_args = args;
+	shared->n_reader = n_reader;
+	shared->n_lines = n_lines;
+	shared->words =
+		(muggle_atomic_int *)(((uintptr_t)mem + 4095) & ~(uintptr_t)4095);
+	memset(shared->words, 0xff, n_bytes);
+	shared->seq.v = 0;
+
+	// run readers
+	thread_args_t th_args[MAX_N_READER];
+	muggle_thread_t th_reader[MAX_N_READER];
+	for (int32_t r = 0; r < n_reader; ++r) {
+		memset(&th_args[r], 0, sizeof(th_args[r]));
+		th_args[r].idx = r;
+		th_args[r].shared = shared;
+		th_args[r].datas = r_datas + r * total_cnt;
+		muggle_thread_create(&th_reader[r], proc_reader, &th_args[r]);
+	}
+
+	// run writer
+	proc_writer(shared, w_datas);
+
+	// cleanup readers
+	for (int32_t r = 0; r < n_reader; ++r) {
+		muggle_thread_join(&th_reader[r]);
+	}
+
+	// output report
+	char name[128];
+	char writer_core[16];
+	char reader_cores[256];
+	snprintf(writer_core, sizeof(writer_core), "%d", args->writer_core);
+	c2c_benchmark_core_list_str(args->reader_cores, n_reader, reader_cores,
+								sizeof(reader_cores));
+
+	const char *noise_suffix = args->noisy ? "_noise" : "";
+	snprintf(name, sizeof(name), "seqlock_k%d_n%d_write%s", n_lines, n_reader,
+			 noise_suffix);
+	row->write_val = c2c_benchmark_gen_report_cores(
+		name, writer_core, reader_cores, w_datas, total_cnt, 0);
+
+	snprintf(name, sizeof(name), "seqlock_k%d_n%d%s", n_lines, n_reader,
+			 noise_suffix);
+	for (int32_t r = 0; r < n_reader; ++r) {
+		thread_args_t *th = &th_args[r];
+		reader_result_t *result = &row->readers[r];
+		result->p50 = -1;
+		result->p99 = -1;
+		if (th->n_snapshot > 0) {
+			result->p50 = c2c_benchmark_gen_report(
+				name, args->writer_core, args->reader_cores[r], th->datas,
+				th->n_snapshot, 0);
+			result->p99 =
+				c2c_benchmark_percentile(th->datas, th->n_snapshot, 99.0);
+		}
+		result->n_snapshot = th->n_snapshot;
+		result->n_retry = th->n_retry;
+		result->n_torn = th->n_torn;
+		result->n_wait = th->n_wait;
+		result->wait_ns = th->wait_ns;
+		memcpy(result->hist, th->hist, sizeof(result->hist));
+	}
+	row->done = 1;
+
+	// cleanup datas
+	free(shared);
+	free(r_datas);
+	free(w_datas);
+	free(mem);
+}
+
+/**
+ * @brief max p50/p99 across readers of row, -1 if no reader got a snapshot
+ */
+static void row_max(const row_t *row, int32_t n_reader, int64_t *p50,
+					int64_t *p99)
+{
+	*p50 = -1;
+	*p99 = -1;
+	for (int32_t r = 0; r < n_reader; ++r) {
+		if (row->readers[r].p50 > *p50) {
+			*p50 = row->readers[r].p50;
+		}
+		if (row->readers[r].p99 > *p99) {
+			*p99 = row->readers[r].p99;
+		}
+	}
+}
+
+/**
+ * @brief run every record size and number of readers, quiet or under noise
+ */
+void run_sweep(void *p, int32_t noisy)
+{
+	sweep_t *sweep = (sweep_t *)p;
+	args_t *args = sweep->args;
+	row_t *rows = sweep->rows[noisy];
+
+	args->noisy = noisy;
+	int32_t n_begin = args->sweep ? 1 : args->n_reader;
+	for (int32_t i = 0; i < args->n_line_cnt; ++i) {
+		for (int32_t n = n_begin; n <= args->n_reader; ++n) {
+			run_seqlock(args, args->line_cnts[i], n,
+						&rows[i * args->n_reader + n - 1]);
+		}
+	}
+	args->noisy = 0;
+}
+
+/**
+ * @brief print table and summary of sweep, with delta of noise run against
+ * quiet run if noisy
+ */
+void report_sweep(args_t *args, sweep_t *sweep, int noisy)
+{
+	char reader_cores[256];
+	c2c_benchmark_core_list_str(args->reader_cores, args->n_reader,
+								reader_cores, sizeof(reader_cores));
+	char summary_filepath[MUGGLE_MAX_PATH];
+	snprintf(summary_filepath, sizeof(summary_filepath),
+			 "./c2c_benchmark_reports/summary_seqlock_c%d_to_c%s.csv",
+			 args->writer_core, reader_cores);
+	FILE *fp = muggle_os_fopen(summary_filepath, "w");
+	if (fp) {
+		fprintf(fp, "lines,n_reader,core,write,p50,p99,snapshots,retries,"
+					"torn,odd_waits,odd_wait_ns");
+		for (int b = 0; b < N_RETRY_BUCKET; ++b) {
+			fprintf(fp, ",retry_%s", s_bucket_names[b]);
+		}
+		c2c_benchmark_noise_csv_head(fp, noisy);
+		fprintf(fp, "\n");
+	}
+
+	// retry/rd and r*% count failed validations; wait% is snapshots that
+	// waited on odd seq, wait(ns) their average wait
+	fprintf(stdout, "%6s%8s%12s%12s%12s%10s%8s%10s", "lines", "readers",
+			"write(ns)", "rd_p50(ns)", "rd_p99(ns)", "retry/rd", "wait%",
+			"wait(ns)");
+	for (int b = 0; b < N_RETRY_BUCKET; ++b) {
+		char col[16];
+		snprintf(col, sizeof(col), "r%s%%", s_bucket_names[b]);
+		fprintf(stdout, "%8s", col);
+	}
+	c2c_benchmark_noise_print_head(stdout, noisy);
+	fprintf(stdout, "\n");
+
+	int32_t n_begin = args->sweep ? 1 : args->n_reader;
+	for (int32_t i = 0; i < args->n_line_cnt; ++i) {
+		for (int32_t n = n_begin; n <= args->n_reader; ++n) {
+			int32_t n_lines = args->line_cnts[i];
+			int32_t idx = i * args->n_reader + n - 1;
+			row_t *row = &sweep->rows[0][idx];
+			row_t *noise_row = &sweep->rows[1][idx];
+			if (!row->done) {
+				LOG_ERROR("failed run with %d lines, %d readers", n_lines, n);
+				continue;
+			}
+
+			uint64_t n_snapshot = 0;
+			uint64_t n_retry = 0;
+			uint64_t n_wait = 0;
+			int64_t wait_ns = 0;
+			uint64_t hist[N_RETRY_BUCKET];
+			memset(hist, 0, sizeof(hist));
+			for (int32_t r = 0; r < n; ++r) {
+				reader_result_t *result = &row->readers[r];
+				reader_result_t *noise_result = &noise_row->readers[r];
+				n_snapshot += result->n_snapshot;
+				n_retry += result->n_retry;
+				n_wait += result->n_wait;
+				wait_ns += result->wait_ns;
+				for (int b = 0; b < N_RETRY_BUCKET; ++b) {
+					hist[b] += result->hist[b];
+				}
+
+				if (fp) {
+					fprintf(fp,
+							"%d,%d,%d,%lld,%lld,%lld,%d,%llu,%llu,%llu,%lld",
+							n_lines, n, args->reader_cores[r],
+							(long long)row->write_val, (long long)result->p50,
+							(long long)result->p99, result->n_snapshot,
+							(unsigned long long)result->n_retry,
+							(unsigned long long)result->n_torn,
+							(unsigned long long)result->n_wait,
+							(long long)result->wait_ns);
+					for (int b = 0; b < N_RETRY_BUCKET; ++b) {
+						fprintf(fp, ",%llu",
+								(unsigned long long)result->hist[b]);
+					}
+					c2c_benchmark_noise_csv_delta(
+						fp, noisy, result->p50, result->p99,
+						noise_row->done ? noise_result->p50 : -1,
+						noise_result->p99);
+					fprintf(fp, "\n");
+				}
+			}
+
+			int64_t max_p50, max_p99;
+			int64_t noise_p50 = -1;
+			int64_t noise_p99 = -1;
+			row_max(row, n, &max_p50, &max_p99);
+			if (noise_row->done) {
+				row_max(noise_row, n, &noise_p50, &noise_p99);
+			}
+			double retry_rate =
+				n_snapshot > 0 ? (double)n_retry / (double)n_snapshot : 0.0;
+			double wait_pct = n_snapshot > 0 ? (double)n_wait * 100.0 /
+												   (double)n_snapshot
+											 : 0.0;
+			int64_t wait_avg = n_wait > 0 ? wait_ns / (int64_t)n_wait : 0;
+			fprintf(stdout, "%6d%8d%12lld%12lld%12lld%10.3f%8.2f%10lld",
+					n_lines, n, (long long)row->write_val,
+					(long long)max_p50, (long long)max_p99, retry_rate,
+					wait_pct, (long long)wait_avg);
+			for (int b = 0; b < N_RETRY_BUCKET; ++b) {
+				double pct = n_snapshot > 0 ? (double)hist[b] * 100.0 /
+												  (double)n_snapshot
+											: 0.0;
+				fprintf(stdout, "%8.2f", pct);
+			}
+			c2c_benchmark_noise_print_delta(stdout, noisy, max_p50, max_p99,
+											noise_p50, noise_p99);
+			fprintf(stdout, "\n");
+		}
+	}
+
+	if (fp) {
+		fclose(fp);
+		LOG_INFO("generate summary report: %s", summary_filepath);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	// initialize log
+	if (muggle_log_complicated_init(MUGGLE_LOG_LEVEL_INFO,
+									MUGGLE_LOG_LEVEL_INFO,
+									"logs/c2c_benchmark_seqlock.log") != 0) {
+		fprintf(stderr, "failed init log\n");
+		exit(EXIT_FAILURE);
+	}
+
+	args_t args;
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
+	LOG_INFO("----------------");
+	LOG_INFO("writer_core: %d", args.writer_core);
+	LOG_INFO("n_reader: %d", args.n_reader);
+	for (int32_t i = 0; i < args.n_reader; ++i) {
+		LOG_INFO("reader_core[%d]: %d", i, args.reader_cores[i]);
+	}
+	LOG_INFO("total_cnt: %d", args.total_cnt);
+	LOG_INFO("write_interval_ns: %d", args.write_interval_ns);
+	LOG_INFO("sweep: %d", args.sweep);
+	for (int32_t i = 0; i < args.n_line_cnt; ++i) {
+		LOG_INFO("line_cnts[%d]: %d", i, args.line_cnts[i]);
+	}
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
+	LOG_INFO("----------------");
+
+	if (args.writer_core == -1 || args.n_reader == 0) {
+		LOG_ERROR("run without writer or reader");
+		exit(EXIT_FAILURE);
+	}
+
+	int32_t cores[1 + MAX_N_READER];
+	cores[0] = args.writer_core;
+	memcpy(cores + 1, args.reader_cores, sizeof(int32_t) * args.n_reader);
+	c2c_benchmark_preflight("seqlock", cores, 1 + args.n_reader);
+
+	sweep_t sweep;
+	size_t n_row = (size_t)args.n_line_cnt * args.n_reader;
+	sweep.args = &args;
+	sweep.rows[0] = (row_t *)calloc(2 * n_row, sizeof(row_t));
+	if (sweep.rows[0] == NULL) {
+		LOG_ERROR("failed allocate rows");
+		exit(EXIT_FAILURE);
+	}
+	sweep.rows[1] = sweep.rows[0] + n_row;
+	int noisy = c2c_benchmark_noise_run(&noise_args, cores, 1 + args.n_reader,
+										run_sweep, &sweep);
+	if (noise_args.n_spec > 0 && !noisy) {
+		fprintf(stdout, "noise skipped\n");
+	}
+	report_sweep(&args, &sweep, noisy);
+	free(sweep.rows[0]);
+
+	return 0;
+}
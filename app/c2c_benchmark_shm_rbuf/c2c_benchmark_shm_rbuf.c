@@ -1,36 +1,161 @@
 #include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+#include "c2c_benchmark_spsc.h"
+#include "c2c_benchmark_skew.h"
+#include "c2c_benchmark_cache.h"
+#include "c2c_benchmark_freq.h"
+#include "c2c_benchmark_depth.h"
+
+#define CONSUMER_MODE_COPY 0
+#define CONSUMER_MODE_INPLACE 1
+#define CONSUMER_MODE_BATCH 2
+
+#define MAX_N_STRIDE 8
+#define MAX_N_SWEEP 16
+#define MAX_N_MODE 3
+#define MAX_N_COMPARE (MAX_N_MODE + 1)
+
+#define SHM_RBUF_BYTES (4 * 1024 * 1024)
 
 typedef struct {
 	int32_t rounds;
 	int32_t record_per_round;
+	int32_t n_burst;
+	int32_t bursts[MAX_N_SWEEP];
+	uint32_t ring_bytes; //!< bytes of ring in current run
+	int32_t n_ring_bytes;
+	uint32_t ring_bytes_list[MAX_N_SWEEP];
 	int32_t round_interval_ns;
 	int32_t producer_core;
 	int32_t consumer_core;
+	int32_t consumer_mode; //!< consumer mode of current run
+	int32_t n_mode;
+	int32_t modes[MAX_N_MODE]; //!< compare modes if more than one
+	int32_t batch_size;
+	int32_t skew_threshold_ns;
+	int32_t noisy;
+	int32_t cache;
+	int32_t cache_only;
+	int32_t cache_expire_sec;
+	uint32_t seed;
+	int32_t stride; //!< bytes of message slot in current run
+	int32_t n_stride;
+	int32_t strides[MAX_N_STRIDE];
 } args_t;
 
+typedef struct {
+	int64_t middle_val;
+	int64_t p99;
+	double throughput;
+	int32_t skew_estimated;
+	c2c_benchmark_skew_t skew;
+	int64_t producer_mhz;
+	int64_t consumer_mhz;
+	int64_t cycles;
+	uint32_t pitch; //!< real bytes between consecutive messages
+	uint64_t n_blocked; //!< messages that hit a full ring
+	int64_t blocked_ns; //!< total time producer was blocked by full ring
+	int32_t depth_computed;
+	c2c_benchmark_depth_t depth;
+} result_t;
+
 typedef struct {
 	args_t *sys_args;
 	muggle_shm_ringbuf_t *shm_rbuf;
+	c2c_benchmark_spsc_t *spsc;
+	uint32_t payload_bytes; //!< bytes allocated per muggle_shm_ringbuf entry
 	cache_line_data_t *datas;
+	int64_t producer_mhz;
+	int64_t consumer_mhz;
+	uint64_t n_blocked;
+	int64_t blocked_ns;
 } thread_args_t;
 
-void parse_args(int argc, char **argv, args_t *args)
+static const char *consumer_mode_name(int32_t mode)
+{
+	switch (mode) {
+	case CONSUMER_MODE_INPLACE:
+		return "inplace";
+	case CONSUMER_MODE_BATCH:
+		return "batch";
+	default:
+		return "copy";
+	}
+}
+
+/**
+ * @brief consumer mode name with batch size, e.g. 'copy' or 'batch16'
+ */
+static void format_mode(int32_t mode, int32_t batch_size, char *buf,
+						size_t size)
+{
+	if (mode == CONSUMER_MODE_BATCH) {
+		snprintf(buf, size, "batch%d", batch_size);
+	} else {
+		snprintf(buf, size, "%s", consumer_mode_name(mode));
+	}
+}
+
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
 {
 	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
 	args->rounds = 1000;
 	args->record_per_round = 1;
+	args->n_burst = 0;
+	args->ring_bytes = SHM_RBUF_BYTES;
+	args->n_ring_bytes = 0;
 	args->round_interval_ns = 1000;
 	args->producer_core = -1;
 	args->consumer_core = -1;
+	args->consumer_mode = CONSUMER_MODE_COPY;
+	args->batch_size = 16;
+	args->skew_threshold_ns = 0;
+	args->seed = (uint32_t)time(NULL);
+	args->n_stride = 0;
 
 	int opt;
-	while ((opt = getopt(argc, argv, "r:m:i:p:c:h")) != -1) {
+	while ((opt = getopt(argc, argv, "r:m:q:i:p:c:t:b:k:S:O:N:R:LCE:Xh")) !=
+		   -1) {
 		switch (opt) {
 		case 'r': {
 			args->rounds = atoi(optarg);
 		} break;
 		case 'm': {
-			args->record_per_round = atoi(optarg);
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				int32_t burst = atoi(token);
+				if (burst > 0) {
+					args->bursts[args->n_burst++] = burst;
+				}
+				token = strtok(NULL, ",");
+				if (args->n_burst >= MAX_N_SWEEP) {
+					break;
+				}
+			}
+		} break;
+		case 'q': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				uint32_t n_bytes = (uint32_t)strtoul(token, NULL, 10);
+				if (n_bytes < 4096 || (n_bytes & (n_bytes - 1)) != 0) {
+					LOG_ERROR("invalid ring bytes: %s, need power of 2 and "
+							  ">= 4096",
+							  token);
+					exit(EXIT_FAILURE);
+				}
+				args->ring_bytes_list[args->n_ring_bytes++] = n_bytes;
+				token = strtok(NULL, ",");
+				if (args->n_ring_bytes >= MAX_N_SWEEP) {
+					break;
+				}
+			}
 		} break;
 		case 'i': {
 			args->round_interval_ns = atoi(optarg);
@@ -41,27 +166,157 @@ void parse_args(int argc, char **argv, args_t *args)
 		case 'c': {
 			args->consumer_core = atoi(optarg);
 		} break;
+		case 't': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL && args->n_mode < MAX_N_MODE) {
+				int32_t mode = -1;
+				if (strcmp(token, "copy") == 0) {
+					mode = CONSUMER_MODE_COPY;
+				} else if (strcmp(token, "inplace") == 0) {
+					mode = CONSUMER_MODE_INPLACE;
+				} else if (strcmp(token, "batch") == 0) {
+					mode = CONSUMER_MODE_BATCH;
+				} else {
+					LOG_ERROR("invalid consumer mode: %s", token);
+				}
+				for (int32_t i = 0; i < args->n_mode; ++i) {
+					if (args->modes[i] == mode) {
+						mode = -1;
+						break;
+					}
+				}
+				if (mode != -1) {
+					args->modes[args->n_mode++] = mode;
+				}
+				token = strtok(NULL, ",");
+			}
+		} break;
+		case 'b': {
+			args->batch_size = atoi(optarg);
+			if (args->batch_size < 1) {
+				args->batch_size = 1;
+			}
+		} break;
+		case 'k': {
+			args->skew_threshold_ns = atoi(optarg);
+		} break;
+		case 'S': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				int32_t stride = atoi(token);
+				if (stride < 64 || stride % 64 != 0) {
+					LOG_ERROR("invalid stride: %s, need multiple of 64",
+							  token);
+					exit(EXIT_FAILURE);
+				}
+				args->strides[args->n_stride++] = stride;
+				token = strtok(NULL, ",");
+				if (args->n_stride >= MAX_N_STRIDE) {
+					break;
+				}
+			}
+		} break;
+		case 'O': {
+			args->seed = (uint32_t)strtoul(optarg, NULL, 10);
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
+		case 'C': {
+			args->cache = 1;
+		} break;
+		case 'E': {
+			args->cache_expire_sec = atoi(optarg);
+		} break;
+		case 'X': {
+			args->cache_only = 1;
+		} break;
 		case 'h': {
 			printf("Usage of %s:\n"
 				   "  -r int\n"
 				   "    rounds\n"
-				   "  -m int\n"
-				   "    record per round\n"
+				   "  -m int array split with comma\n"
+				   "    record per round, sweep burst size if more than one\n"
+				   "  -q int array split with comma\n"
+				   "    bytes of ring, power of 2, sweep if more than one;\n"
+				   "    default 4194304\n"
 				   "  -i int\n"
 				   "    round interval (nanoseconds)\n"
 				   "  -p int\n"
 				   "    producer bind core\n"
 				   "  -c int\n"
 				   "    consumer bind core\n"
+				   "  -t string array split with comma\n"
+				   "    consumer mode; 'copy', 'inplace' or 'batch'\n"
+				   "    copy: memcpy entry, publish read index per message\n"
+				   "    inplace: no entry copy, publish read index per "
+				   "message\n"
+				   "    batch: no entry copy, publish read index per batch;\n"
+				   "    runs on a private spsc ring instead of\n"
+				   "    muggle_shm_ringbuf, so compare with '-t batch -b 1'\n"
+				   "    to see the batching effect alone\n"
+				   "    more than one mode, e.g. 'copy,inplace,batch', runs\n"
+				   "    each mode back to back on the same core pair and\n"
+				   "    prints p50/p99/msg/s and delta against copy (or the\n"
+				   "    first mode); batch also runs with -b 1, so ring\n"
+				   "    change (batch1 - inplace) and batching (batch -\n"
+				   "    batch1) show up separately\n"
+				   "  -b int\n"
+				   "    max messages per batch in 'batch' consumer mode,\n"
+				   "    1 is the per message baseline on the same ring\n"
+				   "  -k int\n"
+				   "    clock skew threshold (nanoseconds); if > 0, estimate\n"
+				   "    producer/consumer clock skew before run, correct\n"
+				   "    latency and flag result when skew bound exceeds it;\n"
+				   "    invalid estimate (inconsistent bounds) is reported\n"
+				   "    and latency is not corrected\n"
+				   "  -S int array split with comma\n"
+				   "    bytes of message slot, multiple of 64, e.g.\n"
+				   "    64,128,256 shows adjacent line prefetcher\n"
+				   "    interference between slots; default 64; copy and\n"
+				   "    inplace mode shrink payload so entry header is\n"
+				   "    inside the slot, real pitch is reported\n"
+				   "  -O int\n"
+				   "    random seed of matrix pair order, 0 is sequential\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
+				   C2C_BENCHMARK_CACHE_USAGE
 				   "",
 				   argv[0]);
 			exit(EXIT_SUCCESS);
 		} break;
 		}
 	}
+
+	if (args->n_mode == 0) {
+		args->modes[args->n_mode++] = CONSUMER_MODE_COPY;
+	}
+	args->consumer_mode = args->modes[0];
+	if (args->n_stride == 0) {
+		args->strides[args->n_stride++] = 64;
+	}
+	args->stride = args->strides[0];
+	if (args->n_burst == 0) {
+		args->bursts[args->n_burst++] = 1;
+	}
+	args->record_per_round = args->bursts[0];
+	if (args->n_ring_bytes == 0) {
+		args->ring_bytes_list[args->n_ring_bytes++] = args->ring_bytes;
+	}
+	args->ring_bytes = args->ring_bytes_list[0];
 }
 
-muggle_shm_ringbuf_t *init_shm_ringbuf(muggle_shm_t *shm)
+muggle_shm_ringbuf_t *init_shm_ringbuf(muggle_shm_t *shm, uint32_t n_bytes)
 {
 	const char *k_name = "/dev/shm/benchmark_c2c_benchmark";
 	const int k_num = 5;
@@ -77,7 +332,6 @@ muggle_shm_ringbuf_t *init_shm_ringbuf(muggle_shm_t *shm)
 	}
 #endif
 
-	uint32_t n_bytes = 4 * 1024 * 1024;
 	int flag = MUGGLE_SHM_FLAG_CREAT;
 	muggle_shm_ringbuf_t *shm_rbuf =
 		muggle_shm_ringbuf_open(shm, k_name, k_num, flag, n_bytes);
@@ -92,6 +346,55 @@ muggle_shm_ringbuf_t *init_shm_ringbuf(muggle_shm_t *shm)
 	return shm_rbuf;
 }
 
+/**
+ * @brief bytes between two consecutive entries of n_bytes payload
+ *
+ * muggle_shm_ringbuf puts a header before payload and rounds entry up to
+ * whole cache lines, so pitch is probed on the ring instead of computed
+ */
+static uint32_t probe_shm_ringbuf_pitch(muggle_shm_ringbuf_t *shm_rbuf,
+										uint32_t n_bytes)
+{
+	char *p0 = (char *)muggle_shm_ringbuf_w_alloc_bytes(shm_rbuf, n_bytes);
+	if (p0 == NULL) {
+		return 0;
+	}
+	muggle_shm_ringbuf_w_move(shm_rbuf);
+	char *p1 = (char *)muggle_shm_ringbuf_w_alloc_bytes(shm_rbuf, n_bytes);
+	if (p1) {
+		muggle_shm_ringbuf_w_move(shm_rbuf);
+	}
+
+	// drain probe entries
+	uint32_t n_fetch = 0;
+	for (int i = p1 ? 2 : 1; i > 0; --i) {
+		while (muggle_shm_ringbuf_r_fetch(shm_rbuf, &n_fetch) == NULL)
+			;
+		muggle_shm_ringbuf_r_move(shm_rbuf);
+	}
+
+	return p1 > p0 ? (uint32_t)(p1 - p0) : 0;
+}
+
+/**
+ * @brief largest payload that keeps entry pitch at stride
+ *
+ * @param pitch  output real pitch of returned payload
+ */
+uint32_t fit_shm_ringbuf_payload(muggle_shm_ringbuf_t *shm_rbuf,
+								 uint32_t stride, uint32_t *pitch)
+{
+	// message needs the time counter at least
+	const uint32_t min_bytes = (uint32_t)sizeof(muggle_time_counter_t);
+	uint32_t n_bytes = stride;
+	*pitch = probe_shm_ringbuf_pitch(shm_rbuf, n_bytes);
+	while (*pitch > stride && n_bytes >= min_bytes + 8) {
+		n_bytes -= 8;
+		*pitch = probe_shm_ringbuf_pitch(shm_rbuf, n_bytes);
+	}
+	return n_bytes;
+}
+
 void clear_shm_ringbuf(muggle_shm_t *shm)
 {
 	if (muggle_shm_detach(shm) != 0) {
@@ -107,6 +410,78 @@ void clear_shm_ringbuf(muggle_shm_t *shm)
 	LOG_INFO("success shm remove");
 }
 
+void consume_copy(muggle_shm_ringbuf_t *shm_rbuf, cache_line_data_t *datas,
+				  size_t total_cnt)
+{
+	size_t n = 0;
+	while (1) {
+		uint32_t n_bytes = 0;
+		cache_line_data_t *ptr =
+			(cache_line_data_t *)muggle_shm_ringbuf_r_fetch(shm_rbuf, &n_bytes);
+		if (ptr) {
+			muggle_time_counter_end(&ptr->tc);
+			memcpy(&datas[n], ptr,
+				   n_bytes < sizeof(*ptr) ? n_bytes : sizeof(*ptr));
+
+			muggle_shm_ringbuf_r_move(shm_rbuf);
+
+			if (++n == total_cnt) {
+				break;
+			}
+		}
+	}
+}
+
+void consume_inplace(muggle_shm_ringbuf_t *shm_rbuf, cache_line_data_t *datas,
+					 size_t total_cnt)
+{
+	size_t n = 0;
+	while (1) {
+		uint32_t n_bytes = 0;
+		cache_line_data_t *ptr =
+			(cache_line_data_t *)muggle_shm_ringbuf_r_fetch(shm_rbuf, &n_bytes);
+		if (ptr) {
+			// only the start timestamp is read from the entry
+			datas[n].tc.start_ts = ptr->tc.start_ts;
+			muggle_time_counter_end(&datas[n].tc);
+
+			muggle_shm_ringbuf_r_move(shm_rbuf);
+
+			if (++n == total_cnt) {
+				break;
+			}
+		}
+	}
+}
+
+void consume_batch(c2c_benchmark_spsc_t *spsc, cache_line_data_t *datas,
+				   size_t total_cnt, int32_t batch_size)
+{
+	size_t n = 0;
+	while (1) {
+		uint32_t n_avail = c2c_benchmark_spsc_r_available(spsc);
+		if (n_avail == 0) {
+			continue;
+		}
+		if (n_avail > (uint32_t)batch_size) {
+			n_avail = (uint32_t)batch_size;
+		}
+
+		for (uint32_t i = 0; i < n_avail; ++i) {
+			cache_line_data_t *ptr =
+				(cache_line_data_t *)c2c_benchmark_spsc_r_slot(spsc, i);
+			datas[n + i].tc.start_ts = ptr->tc.start_ts;
+			muggle_time_counter_end(&datas[n + i].tc);
+		}
+		c2c_benchmark_spsc_r_move(spsc, n_avail);
+
+		n += n_avail;
+		if (n == total_cnt) {
+			break;
+		}
+	}
+}
+
 muggle_thread_ret_t proc_consumer(void *p)
 {
 	thread_args_t *p_args = (thread_args_t *)p;
@@ -129,23 +504,21 @@ muggle_thread_ret_t proc_consumer(void *p)
 
 	// run consumer
 	LOG_INFO("run consumer");
+	c2c_benchmark_freq_t freq;
+	c2c_benchmark_freq_begin(&freq, args->consumer_core);
 	size_t total_cnt = (size_t)args->rounds * (size_t)args->record_per_round;
-	size_t n = 0;
-	while (1) {
-		uint32_t n_bytes = 0;
-		cache_line_data_t *ptr =
-			(cache_line_data_t *)muggle_shm_ringbuf_r_fetch(shm_rbuf, &n_bytes);
-		if (ptr) {
-			muggle_time_counter_end(&ptr->tc);
-			memcpy(&datas[n], ptr, sizeof(*ptr));
-
-			muggle_shm_ringbuf_r_move(shm_rbuf);
-
-			if (++n == total_cnt) {
-				break;
-			}
-		}
+	switch (args->consumer_mode) {
+	case CONSUMER_MODE_INPLACE: {
+		consume_inplace(shm_rbuf, datas, total_cnt);
+	} break;
+	case CONSUMER_MODE_BATCH: {
+		consume_batch(p_args->spsc, datas, total_cnt, args->batch_size);
+	} break;
+	default: {
+		consume_copy(shm_rbuf, datas, total_cnt);
+	} break;
 	}
+	p_args->consumer_mhz = c2c_benchmark_freq_end(&freq);
 	LOG_INFO("consumer completed");
 
 	return 0;
@@ -155,6 +528,7 @@ void proc_producer(thread_args_t *p_args)
 {
 	args_t *args = p_args->sys_args;
 	muggle_shm_ringbuf_t *shm_rbuf = p_args->shm_rbuf;
+	c2c_benchmark_spsc_t *spsc = p_args->spsc;
 
 	// bind core
 	int ret = c2c_benchmark_bind_core(args->producer_core);
@@ -171,29 +545,58 @@ void proc_producer(thread_args_t *p_args)
 
 	// run producer
 	LOG_INFO("run producer");
+	c2c_benchmark_freq_t freq;
+	c2c_benchmark_freq_begin(&freq, args->producer_core);
 	for (int r = 0; r < args->rounds; ++r) {
 		for (int i = 0; i < args->record_per_round; ++i) {
-			cache_line_data_t *ptr = muggle_shm_ringbuf_w_alloc_bytes(
-				shm_rbuf, sizeof(cache_line_data_t));
-			if (ptr == NULL) {
-				LOG_ERROR("failed alloc bytes for write");
-				muggle_msleep(1000);
-				--i;
-				continue;
+			cache_line_data_t *ptr = NULL;
+			int blocked = 0;
+			muggle_time_counter_t block_tc;
+			while (1) {
+				if (spsc) {
+					ptr = (cache_line_data_t *)c2c_benchmark_spsc_w_alloc(spsc);
+				} else {
+					ptr = muggle_shm_ringbuf_w_alloc_bytes(
+						shm_rbuf, p_args->payload_bytes);
+				}
+				if (ptr) {
+					break;
+				}
+
+				// ring full, producer is backpressured
+				if (!blocked) {
+					blocked = 1;
+					muggle_time_counter_init(&block_tc);
+					muggle_time_counter_start(&block_tc);
+				}
+			}
+			if (blocked) {
+				muggle_time_counter_end(&block_tc);
+				++p_args->n_blocked;
+				p_args->blocked_ns +=
+					muggle_time_counter_interval_ns(&block_tc);
 			}
 
 			muggle_time_counter_init(&ptr->tc);
 			muggle_time_counter_start(&ptr->tc);
-			muggle_shm_ringbuf_w_move(shm_rbuf);
+			if (spsc) {
+				c2c_benchmark_spsc_w_move(spsc);
+			} else {
+				muggle_shm_ringbuf_w_move(shm_rbuf);
+			}
 		}
 
 		c2c_benchmark_wait_ns(args->round_interval_ns);
 	}
+	p_args->producer_mhz = c2c_benchmark_freq_end(&freq);
 	LOG_INFO("producer completed");
 }
 
-int64_t run_shm_rbuf(args_t *args)
+int64_t run_shm_rbuf(args_t *args, result_t *result)
 {
+	memset(result, 0, sizeof(*result));
+	result->middle_val = -1;
+
 	// prepare datas
 	size_t total_cnt = (size_t)args->rounds * (size_t)args->record_per_round;
 	cache_line_data_t *datas =
@@ -202,17 +605,61 @@ int64_t run_shm_rbuf(args_t *args)
 		return -1;
 	}
 
+	// estimate clock skew between producer and consumer
+	if (args->skew_threshold_ns > 0) {
+		if (c2c_benchmark_skew_estimate(args->producer_core,
+										args->consumer_core, 1000,
+										&result->skew) == 0) {
+			result->skew_estimated = 1;
+		}
+	}
+
 	// init share ring buffer
+	// NOTE: muggle_shm_ringbuf publishes read index in every r_move, batch
+	// consumer mode use spsc ring with the same entry size and bytes
+	// instead; message only uses the first cache line of a slot, slot size
+	// only changes the spacing between messages. muggle_shm_ringbuf entry
+	// carries a header, so its payload is shrunk until the real pitch is
+	// the slot size
 	muggle_shm_t shm;
-	muggle_shm_ringbuf_t *shm_rbuf = init_shm_ringbuf(&shm);
-	if (shm_rbuf == NULL) {
-		return -1;
+	muggle_shm_ringbuf_t *shm_rbuf = NULL;
+	c2c_benchmark_spsc_t spsc;
+	uint32_t payload_bytes = (uint32_t)args->stride;
+	if (args->consumer_mode == CONSUMER_MODE_BATCH) {
+		if (c2c_benchmark_spsc_init(&spsc, args->ring_bytes / args->stride,
+									(uint32_t)args->stride) != 0) {
+			LOG_ERROR("failed init spsc ring");
+			free(datas);
+			return -1;
+		}
+		result->pitch = (uint32_t)args->stride;
+	} else {
+		shm_rbuf = init_shm_ringbuf(&shm, args->ring_bytes);
+		if (shm_rbuf == NULL) {
+			free(datas);
+			return -1;
+		}
+		payload_bytes = fit_shm_ringbuf_payload(
+			shm_rbuf, (uint32_t)args->stride, &result->pitch);
+		if (result->pitch != (uint32_t)args->stride) {
+			LOG_WARNING("shm_ringbuf slot pitch is %u bytes, not %d",
+						result->pitch, args->stride);
+		}
+		LOG_INFO("shm_ringbuf payload %u bytes, pitch %u bytes",
+				 payload_bytes, result->pitch);
 	}
 
 	thread_args_t th_args;
 	th_args.sys_args = args;
 	th_args.shm_rbuf = shm_rbuf;
+	th_args.spsc =
+		args->consumer_mode == CONSUMER_MODE_BATCH ? &spsc : NULL;
+	th_args.payload_bytes = payload_bytes;
 	th_args.datas = datas;
+	th_args.producer_mhz = 0;
+	th_args.consumer_mhz = 0;
+	th_args.n_blocked = 0;
+	th_args.blocked_ns = 0;
 
 	// run consumer
 	muggle_thread_t th_consumer;
@@ -227,15 +674,557 @@ int64_t run_shm_rbuf(args_t *args)
 	muggle_thread_join(&th_consumer);
 
 	// cleanup share ring buffer
-	clear_shm_ringbuf(&shm);
+	if (shm_rbuf) {
+		clear_shm_ringbuf(&shm);
+	} else {
+		c2c_benchmark_spsc_destroy(&spsc);
+	}
 
 	// output report
-	int64_t middle_val =
-		c2c_benchmark_gen_report("shm_rbuf", args->producer_core,
+	char name[128];
+	char stride_suffix[48] = "";
+	int offset = 0;
+	if (result->pitch != 64) {
+		offset += snprintf(stride_suffix + offset,
+						   sizeof(stride_suffix) - offset, "_S%u",
+						   result->pitch);
+	}
+	if (args->n_burst > 1) {
+		offset += snprintf(stride_suffix + offset,
+						   sizeof(stride_suffix) - offset, "_m%d",
+						   args->record_per_round);
+	}
+	if (args->n_ring_bytes > 1) {
+		snprintf(stride_suffix + offset, sizeof(stride_suffix) - offset,
+				 "_q%u", args->ring_bytes);
+	}
+	if (args->consumer_mode == CONSUMER_MODE_BATCH) {
+		snprintf(name, sizeof(name), "shm_rbuf_batch%d%s%s", args->batch_size,
+				 stride_suffix, args->noisy ? "_noise" : "");
+	} else if (args->consumer_mode == CONSUMER_MODE_INPLACE) {
+		snprintf(name, sizeof(name), "shm_rbuf_inplace%s%s", stride_suffix,
+				 args->noisy ? "_noise" : "");
+	} else {
+		snprintf(name, sizeof(name), "shm_rbuf%s%s", stride_suffix,
+				 args->noisy ? "_noise" : "");
+	}
+	if (result->skew_estimated) {
+		c2c_benchmark_skew_correct(&result->skew, datas, total_cnt);
+		if (c2c_benchmark_skew_bound(&result->skew) >
+			args->skew_threshold_ns) {
+			LOG_WARNING("%s c%d -> c%d clock skew bound %lld ns exceeds "
+						"threshold %d ns",
+						name, args->producer_core, args->consumer_core,
+						(long long)c2c_benchmark_skew_bound(&result->skew),
+						args->skew_threshold_ns);
+		}
+	}
+	result->throughput = c2c_benchmark_throughput(datas, total_cnt);
+	LOG_INFO("%s throughput: %.0f msg/s", name, result->throughput);
+	result->middle_val =
+		c2c_benchmark_gen_report(name, args->producer_core,
 								 args->consumer_core, datas, total_cnt, 0);
+	result->p99 = c2c_benchmark_percentile(datas, total_cnt, 99.0);
+	result->producer_mhz = th_args.producer_mhz;
+	result->consumer_mhz = th_args.consumer_mhz;
+	result->cycles = c2c_benchmark_ns_to_cycles(
+		result->middle_val, (result->producer_mhz + result->consumer_mhz) / 2);
+	result->n_blocked = th_args.n_blocked;
+	result->blocked_ns = th_args.blocked_ns;
+
+	// queue depth at dequeue
+	if (c2c_benchmark_depth_compute(datas, total_cnt, &result->depth) == 0) {
+		char producer_core[16];
+		char consumer_core[16];
+		snprintf(producer_core, sizeof(producer_core), "%d",
+				 args->producer_core);
+		snprintf(consumer_core, sizeof(consumer_core), "%d",
+				 args->consumer_core);
+		result->depth_computed = 1;
+		c2c_benchmark_depth_report(name, producer_core, consumer_core,
+								   &result->depth);
+	}
 
 	free(datas);
-	return middle_val;
+	return result->middle_val;
+}
+
+/**
+ * @brief print single pair result
+ */
+void print_result(args_t *args, const char *prefix, result_t *result)
+{
+	fprintf(stdout, "%d -> %d: %s%lld", args->producer_core,
+			args->consumer_core, prefix, (long long)result->middle_val);
+	if (result->skew_estimated) {
+		fprintf(stdout, " +-%lld", (long long)result->skew.error_ns);
+		if (c2c_benchmark_skew_bound(&result->skew) >
+			args->skew_threshold_ns) {
+			fprintf(stdout, " [skew bound %lld ns]",
+					(long long)c2c_benchmark_skew_bound(&result->skew));
+		}
+	} else if (args->skew_threshold_ns > 0) {
+		fprintf(stdout, " [skew invalid]");
+	}
+	fprintf(stdout, ", %lld cycles, %lld/%lld MHz", (long long)result->cycles,
+			(long long)result->producer_mhz, (long long)result->consumer_mhz);
+	fprintf(stdout, ", throughput: %.0f msg/s", result->throughput);
+	fprintf(stdout, ", blocked writes: %llu, blocked time: %lld ns\n",
+			(unsigned long long)result->n_blocked,
+			(long long)result->blocked_ns);
+}
+
+typedef struct {
+	args_t *args;
+	result_t *results[2]; //!< quiet and noise result
+} pair_run_t;
+
+/**
+ * @brief run pair quiet or under noise
+ */
+static void run_pair(void *p, int32_t noisy)
+{
+	pair_run_t *run = (pair_run_t *)p;
+	run->args->noisy = noisy;
+	run_shm_rbuf(run->args, run->results[noisy]);
+	run->args->noisy = 0;
+}
+
+/**
+ * @brief run quiet, then run again under noise if noise spec exists
+ *
+ * middle value of noise_result is -1 if noise skipped
+ *
+ * @return middle value of quiet run
+ */
+int64_t run_with_noise(args_t *args, c2c_benchmark_noise_args_t *noise_args,
+					   result_t *quiet_result, result_t *noise_result)
+{
+	memset(noise_result, 0, sizeof(*noise_result));
+	pair_run_t run;
+	run.args = args;
+	run.results[0] = quiet_result;
+	run.results[1] = noise_result;
+	int32_t measured_cores[2] = { args->producer_core, args->consumer_core };
+	if (!c2c_benchmark_noise_run(noise_args, measured_cores, 2, run_pair,
+								 &run) &&
+		noise_args->n_spec > 0) {
+		noise_result->middle_val = -1;
+	}
+	return quiet_result->middle_val;
+}
+
+/**
+ * @brief parameters that affect result of a pair, key of cache
+ */
+void format_params(args_t *args, c2c_benchmark_noise_args_t *noise_args,
+				   char *buf, size_t size)
+{
+	int offset = snprintf(
+		buf, size, "r=%d,m=%d,q=%u,i=%d,t=%s,b=%d,k=%d,S=%d,R=%d,L=%d,noise=",
+		args->rounds, args->record_per_round, args->ring_bytes,
+		args->round_interval_ns, consumer_mode_name(args->consumer_mode),
+		args->batch_size, args->skew_threshold_ns, args->stride,
+		c2c_benchmark_get_sched_fifo(), c2c_benchmark_get_lock_memory());
+	for (int32_t i = 0; i < noise_args->n_spec; ++i) {
+		if (offset < 0 || (size_t)offset >= size) {
+			break;
+		}
+		offset += snprintf(buf + offset, size - offset, "%s%s",
+						   i == 0 ? "" : ";", noise_args->specs[i]);
+	}
+}
+
+/**
+ * @brief run all core pairs and print matrix
+ */
+void run_matrix(args_t *args, c2c_benchmark_noise_args_t *noise_args,
+				long num_cores)
+{
+	int64_t *arr =
+		(int64_t *)malloc(sizeof(int64_t) * num_cores * num_cores * 5);
+	memset(arr, 0, sizeof(int64_t) * num_cores * num_cores * 5);
+	int64_t *arr_noise = arr + num_cores * num_cores;
+	int64_t *arr_skew = arr_noise + num_cores * num_cores;
+	int64_t *arr_cycles = arr_skew + num_cores * num_cores;
+	int64_t *arr_bound = arr_cycles + num_cores * num_cores;
+
+	int64_t *min_mhz = (int64_t *)malloc(sizeof(int64_t) * num_cores * 2);
+	memset(min_mhz, 0, sizeof(int64_t) * num_cores * 2);
+	int64_t *max_mhz = min_mhz + num_cores;
+
+	int32_t *pairs = (int32_t *)malloc(sizeof(int32_t) * num_cores * num_cores);
+	int32_t n_pair =
+		c2c_benchmark_matrix_pairs((int32_t)num_cores, args->seed, pairs);
+
+	c2c_benchmark_cache_t cache;
+	int32_t use_cache = args->cache || args->cache_only;
+	if (use_cache) {
+		char params[1024];
+		format_params(args, noise_args, params, sizeof(params));
+		if (c2c_benchmark_cache_open(&cache, "shm_rbuf", params,
+									 (int32_t)num_cores, 7,
+									 args->cache_expire_sec,
+									 args->cache_only) != 0) {
+			LOG_ERROR("failed open cache");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	int32_t n_missing = 0;
+	for (int32_t k = 0; k < n_pair; ++k) {
+		int32_t i = pairs[k * 2];
+		int32_t j = pairs[k * 2 + 1];
+
+		// vals: middle, noise middle, skew error, cycles, producer MHz,
+		// consumer MHz, skew bound; skew error and bound are -1 if the
+		// skew estimate is invalid
+		int64_t vals[7] = { 0, 0, 0, 0, 0, 0, 0 };
+		if (use_cache && c2c_benchmark_cache_get(&cache, i, j, vals) == 0) {
+			LOG_INFO("%d -> %d: cached", i, j);
+		} else if (args->cache_only) {
+			++n_missing;
+			continue;
+		} else {
+			args->producer_core = i;
+			args->consumer_core = j;
+			result_t quiet_result, noise_result;
+			run_with_noise(args, noise_args, &quiet_result,
+						   &noise_result);
+			vals[0] = quiet_result.middle_val;
+			vals[1] = noise_result.middle_val;
+			vals[2] = -1;
+			vals[3] = quiet_result.cycles;
+			vals[4] = quiet_result.producer_mhz;
+			vals[5] = quiet_result.consumer_mhz;
+			vals[6] = -1;
+			if (quiet_result.skew_estimated) {
+				vals[2] = quiet_result.skew.error_ns;
+				vals[6] = c2c_benchmark_skew_bound(&quiet_result.skew);
+			}
+			// failed run is not a result, measure it again next time
+			if (use_cache && vals[0] != -1) {
+				c2c_benchmark_cache_put(&cache, i, j, vals);
+			}
+		}
+		arr[num_cores * i + j] = vals[0];
+		arr[num_cores * j + i] = vals[0];
+		arr_noise[num_cores * i + j] = vals[1];
+		arr_noise[num_cores * j + i] = vals[1];
+		arr_skew[num_cores * i + j] = vals[2];
+		arr_skew[num_cores * j + i] = vals[2];
+		arr_cycles[num_cores * i + j] = vals[3];
+		arr_cycles[num_cores * j + i] = vals[3];
+		arr_bound[num_cores * i + j] = vals[6];
+		arr_bound[num_cores * j + i] = vals[6];
+
+		int32_t cores[2] = { i, j };
+		for (int32_t c = 0; c < 2; ++c) {
+			int64_t mhz = vals[4 + c];
+			if (min_mhz[cores[c]] == 0 || mhz < min_mhz[cores[c]]) {
+				min_mhz[cores[c]] = mhz;
+			}
+			if (mhz > max_mhz[cores[c]]) {
+				max_mhz[cores[c]] = mhz;
+			}
+		}
+	}
+	free(pairs);
+
+	if (use_cache) {
+		c2c_benchmark_cache_close(&cache);
+	}
+	if (n_missing > 0) {
+		LOG_WARNING("%d pairs missing in cache, filled with 0", n_missing);
+	}
+
+	if (noise_args->n_spec == 0) {
+		c2c_benchmark_print_matrix(stdout, arr, num_cores);
+	} else {
+		fprintf(stdout, "quiet:\n");
+		c2c_benchmark_print_matrix(stdout, arr, num_cores);
+		fprintf(stdout, "noise:\n");
+		c2c_benchmark_print_matrix(stdout, arr_noise, num_cores);
+		int32_t n_skipped = 0;
+		for (long i = 0; i < num_cores * num_cores; ++i) {
+			if (arr_noise[i] < 0) {
+				++n_skipped;
+			} else {
+				arr_noise[i] -= arr[i];
+			}
+		}
+		fprintf(stdout, "delta:\n");
+		c2c_benchmark_print_matrix(stdout, arr_noise, num_cores);
+		if (n_skipped > 0) {
+			fprintf(stdout,
+					"-1: noise skipped, all noise cores are measured cores\n");
+		}
+	}
+	if (args->skew_threshold_ns > 0) {
+		fprintf(stdout, "skew error (+-ns):\n");
+		c2c_benchmark_print_matrix(stdout, arr_skew, num_cores);
+
+		// pairs whose skew bound exceeds threshold, latency of them is not
+		// trustworthy
+		int32_t n_invalid = 0;
+		for (long i = 0; i < num_cores; ++i) {
+			for (long j = i + 1; j < num_cores; ++j) {
+				int64_t bound = arr_bound[num_cores * i + j];
+				if (bound < 0) {
+					++n_invalid;
+				} else if (bound > args->skew_threshold_ns) {
+					fprintf(stdout,
+							"%ld <-> %ld: skew bound %lld ns exceeds "
+							"threshold %d ns\n",
+							i, j, (long long)bound, args->skew_threshold_ns);
+				}
+			}
+		}
+		if (n_invalid > 0) {
+			fprintf(stdout, "-1: skew invalid, latency not corrected\n");
+		}
+	}
+	fprintf(stdout, "cycles:\n");
+	c2c_benchmark_print_matrix(stdout, arr_cycles, num_cores);
+	fprintf(stdout, "frequency:\n");
+	c2c_benchmark_print_freq(stdout, min_mhz, max_mhz, num_cores);
+	free(min_mhz);
+	free(arr);
+}
+
+/**
+ * @brief run single core pair and print result
+ */
+void run_single(args_t *args, c2c_benchmark_noise_args_t *noise_args,
+				result_t *quiet_result_out)
+{
+	result_t quiet_result, noise_result;
+	run_with_noise(args, noise_args, &quiet_result, &noise_result);
+	*quiet_result_out = quiet_result;
+	if (quiet_result.depth_computed) {
+		c2c_benchmark_depth_print(stdout, &quiet_result.depth);
+	}
+	if (noise_args->n_spec == 0) {
+		print_result(args, "", &quiet_result);
+	} else if (noise_result.middle_val < 0) {
+		print_result(args, "quiet ", &quiet_result);
+		fprintf(stdout, "%d -> %d: noise skipped\n", args->producer_core,
+				args->consumer_core);
+	} else {
+		print_result(args, "quiet ", &quiet_result);
+		print_result(args, "noise ", &noise_result);
+		fprintf(stdout, "%d -> %d: delta %lld\n", args->producer_core,
+				args->consumer_core,
+				(long long)(noise_result.middle_val -
+							quiet_result.middle_val));
+	}
+}
+
+/**
+ * @brief print swept parameters of current run
+ */
+void print_sweep_title(args_t *args)
+{
+	int32_t n_title = 0;
+	if (args->n_stride > 1) {
+		fprintf(stdout, "stride %d", args->stride);
+		++n_title;
+	}
+	if (args->n_ring_bytes > 1) {
+		fprintf(stdout, "%sring bytes %u", n_title > 0 ? ", " : "",
+				args->ring_bytes);
+		++n_title;
+	}
+	if (args->n_burst > 1) {
+		fprintf(stdout, "%sburst %d", n_title > 0 ? ", " : "",
+				args->record_per_round);
+		++n_title;
+	}
+	if (n_title > 0) {
+		fprintf(stdout, ":\n");
+	}
+}
+
+/**
+ * @brief summary of burst size and ring bytes sweep; backpressure of a ring
+ * starts at the smallest burst that makes any message hit a full ring
+ */
+void report_sweep(args_t *args, result_t *results)
+{
+	char mode[32];
+	format_mode(args->consumer_mode, args->batch_size, mode, sizeof(mode));
+
+	char filepath[MUGGLE_MAX_PATH];
+	snprintf(filepath, sizeof(filepath),
+			 "./c2c_benchmark_reports/summary_shm_rbuf_%s_c%d_to_c%d.csv",
+			 mode, args->producer_core, args->consumer_core);
+	FILE *fp = muggle_os_fopen(filepath, "w");
+	if (fp) {
+		fprintf(fp, "stride,pitch,ring_bytes,burst,p50,depth_p50,depth_p99,"
+					"depth_max,blocked,blocked_ns\n");
+	}
+
+	fprintf(stdout, "%8s%8s%12s%8s%12s%10s%10s%10s%10s%14s\n", "stride",
+			"pitch", "ring", "burst", "p50(ns)", "depth50", "depth99",
+			"depth_max", "blocked", "blocked(ns)");
+	for (int32_t i = 0; i < args->n_stride; ++i) {
+		for (int32_t q = 0; q < args->n_ring_bytes; ++q) {
+			int32_t backpressure_burst = -1;
+			for (int32_t m = 0; m < args->n_burst; ++m) {
+				result_t *result =
+					&results[(i * args->n_ring_bytes + q) * args->n_burst + m];
+				c2c_benchmark_depth_t *depth = &result->depth;
+				if (result->n_blocked > 0 &&
+					(backpressure_burst == -1 ||
+					 args->bursts[m] < backpressure_burst)) {
+					backpressure_burst = args->bursts[m];
+				}
+				fprintf(stdout,
+						"%8d%8u%12u%8d%12lld%10d%10d%10d%10llu%14lld\n",
+						args->strides[i], result->pitch,
+						args->ring_bytes_list[q], args->bursts[m],
+						(long long)result->middle_val, depth->p50,
+						depth->p99, depth->max,
+						(unsigned long long)result->n_blocked,
+						(long long)result->blocked_ns);
+				if (fp) {
+					fprintf(fp, "%d,%u,%u,%d,%lld,%d,%d,%d,%llu,%lld\n",
+							args->strides[i], result->pitch,
+							args->ring_bytes_list[q], args->bursts[m],
+							(long long)result->middle_val, depth->p50,
+							depth->p99, depth->max,
+							(unsigned long long)result->n_blocked,
+							(long long)result->blocked_ns);
+				}
+			}
+
+			if (backpressure_burst == -1) {
+				fprintf(stdout, "stride %d, ring bytes %u: no backpressure\n",
+						args->strides[i], args->ring_bytes_list[q]);
+			} else {
+				fprintf(stdout,
+						"stride %d, ring bytes %u: backpressure from burst "
+						"%d\n",
+						args->strides[i], args->ring_bytes_list[q],
+						backpressure_burst);
+			}
+		}
+	}
+
+	if (fp) {
+		fclose(fp);
+		LOG_INFO("generate summary report: %s", filepath);
+	}
+}
+
+/**
+ * @brief run every consumer mode back to back on the same core pair, print
+ * p50/p99/msg/s and delta against copy, or against the first mode if copy
+ * is not compared; batch runs with -b 1 first, so the ring change and the
+ * batching show up as separate rows
+ *
+ * @param fp      summary of mode comparison, NULL for no summary
+ * @param result  output result of the first mode
+ */
+void run_compare(args_t *args, c2c_benchmark_noise_args_t *noise_args,
+				 FILE *fp, result_t *result)
+{
+	int32_t modes[MAX_N_COMPARE] = { 0 };
+	int32_t batch_sizes[MAX_N_COMPARE] = { 0 };
+	result_t results[MAX_N_COMPARE];
+	int32_t n_row = 0;
+	int32_t first_row = -1;
+	for (int32_t i = 0; i < args->n_mode; ++i) {
+		if (args->modes[i] == CONSUMER_MODE_BATCH && args->batch_size > 1) {
+			modes[n_row] = CONSUMER_MODE_BATCH;
+			batch_sizes[n_row] = 1;
+			++n_row;
+		}
+		if (i == 0) {
+			first_row = n_row;
+		}
+		modes[n_row] = args->modes[i];
+		batch_sizes[n_row] = args->batch_size;
+		++n_row;
+	}
+
+	int32_t batch_size = args->batch_size;
+	char mode[32];
+	for (int32_t i = 0; i < n_row; ++i) {
+		args->consumer_mode = modes[i];
+		args->batch_size = batch_sizes[i];
+		format_mode(modes[i], batch_sizes[i], mode, sizeof(mode));
+		fprintf(stdout, "mode %s:\n", mode);
+		run_single(args, noise_args, &results[i]);
+	}
+	args->consumer_mode = args->modes[0];
+	args->batch_size = batch_size;
+	*result = results[first_row];
+
+	int32_t ref_row = 0;
+	for (int32_t i = 0; i < n_row; ++i) {
+		if (modes[i] == CONSUMER_MODE_COPY) {
+			ref_row = i;
+			break;
+		}
+	}
+	result_t *ref = &results[ref_row];
+	format_mode(modes[ref_row], batch_sizes[ref_row], mode, sizeof(mode));
+	fprintf(stdout, "delta against %s\n", mode);
+	fprintf(stdout, "%10s%12s%12s%14s%12s%12s%14s\n", "mode", "p50(ns)",
+			"p99(ns)", "msg/s", "d_p50(ns)", "d_p99(ns)", "d_msg/s");
+	for (int32_t i = 0; i < n_row; ++i) {
+		result_t *row = &results[i];
+		format_mode(modes[i], batch_sizes[i], mode, sizeof(mode));
+		if (row->middle_val < 0 || ref->middle_val < 0) {
+			fprintf(stdout, "%10s%12s\n", mode, "failed");
+			continue;
+		}
+		int64_t d_p50 = row->middle_val - ref->middle_val;
+		int64_t d_p99 = row->p99 - ref->p99;
+		double d_throughput = row->throughput - ref->throughput;
+		fprintf(stdout, "%10s%12lld%12lld%14.0f%12lld%12lld%14.0f\n", mode,
+				(long long)row->middle_val, (long long)row->p99,
+				row->throughput, (long long)d_p50, (long long)d_p99,
+				d_throughput);
+		if (fp) {
+			fprintf(fp, "%d,%u,%u,%d,%s,%lld,%lld,%.0f,%lld,%lld,%.0f\n",
+					args->stride, row->pitch, args->ring_bytes,
+					args->record_per_round, mode, (long long)row->middle_val,
+					(long long)row->p99, row->throughput, (long long)d_p50,
+					(long long)d_p99, d_throughput);
+		}
+	}
+
+	// batch1 and inplace both publish read index per message and skip entry
+	// copy, they only differ in ring; batch and batch1 only differ in batching
+	int32_t inplace_row = -1;
+	int32_t batch1_row = -1;
+	for (int32_t i = 0; i < n_row; ++i) {
+		if (modes[i] == CONSUMER_MODE_INPLACE) {
+			inplace_row = i;
+		} else if (modes[i] == CONSUMER_MODE_BATCH && batch_sizes[i] == 1) {
+			batch1_row = i;
+		}
+	}
+	if (batch1_row != -1 && results[batch1_row].middle_val >= 0) {
+		result_t *batch1 = &results[batch1_row];
+		if (inplace_row != -1 && results[inplace_row].middle_val >= 0) {
+			fprintf(stdout, "ring change (batch1 - inplace): p50 %lld ns, "
+							"p99 %lld ns\n",
+					(long long)(batch1->middle_val -
+								results[inplace_row].middle_val),
+					(long long)(batch1->p99 - results[inplace_row].p99));
+		}
+		if (batch_size > 1 && results[batch1_row + 1].middle_val >= 0) {
+			result_t *batch = &results[batch1_row + 1];
+			fprintf(stdout, "batching (batch%d - batch1): p50 %lld ns, "
+							"p99 %lld ns\n",
+					batch_size, (long long)(batch->middle_val -
+											batch1->middle_val),
+					(long long)(batch->p99 - batch1->p99));
+		}
+	}
 }
 
 int main(int argc, char *argv[])
@@ -249,52 +1238,115 @@ int main(int argc, char *argv[])
 	}
 
 	args_t args;
-	parse_args(argc, argv, &args);
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
 	LOG_INFO("----------------");
 	LOG_INFO("rounds: %d", args.rounds);
-	LOG_INFO("record_per_round: %d", args.record_per_round);
+	for (int32_t i = 0; i < args.n_burst; ++i) {
+		LOG_INFO("record_per_round[%d]: %d", i, args.bursts[i]);
+	}
+	for (int32_t i = 0; i < args.n_ring_bytes; ++i) {
+		LOG_INFO("ring_bytes[%d]: %u", i, args.ring_bytes_list[i]);
+	}
 	LOG_INFO("round_interval_ns: %d", args.round_interval_ns);
 	LOG_INFO("producer_core: %d", args.producer_core);
 	LOG_INFO("consumer_core: %d", args.consumer_core);
+	LOG_INFO("consumer_mode: %s", consumer_mode_name(args.consumer_mode));
+	LOG_INFO("batch_size: %d", args.batch_size);
+	LOG_INFO("skew_threshold_ns: %d", args.skew_threshold_ns);
+	LOG_INFO("seed: %u", args.seed);
+	for (int32_t i = 0; i < args.n_stride; ++i) {
+		LOG_INFO("stride[%d]: %d", i, args.strides[i]);
+	}
+	LOG_INFO("cache: %d", args.cache);
+	LOG_INFO("cache_only: %d", args.cache_only);
+	LOG_INFO("cache_expire_sec: %d", args.cache_expire_sec);
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
 	LOG_INFO("----------------");
 
-	if (args.producer_core == -1 || args.producer_core == -1) {
-		long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (args.producer_core == -1 || args.consumer_core == -1) {
+		if (!args.cache_only) {
+			c2c_benchmark_preflight("shm_rbuf", NULL, 0);
+		}
+	} else {
+		int32_t cores[2] = { args.producer_core, args.consumer_core };
+		c2c_benchmark_preflight("shm_rbuf", cores, 2);
+	}
+
+	int32_t is_matrix = args.producer_core == -1 || args.consumer_core == -1;
+	if (is_matrix && args.n_mode > 1) {
+		LOG_ERROR("mode comparison needs producer and consumer core");
+		exit(EXIT_FAILURE);
+	}
+	long num_cores = 0;
+	if (is_matrix) {
+		num_cores = sysconf(_SC_NPROCESSORS_ONLN);
 		if (num_cores == -1) {
 			LOG_ERROR("failed get core numbers: %d", MUGGLE_EVENT_LAST_ERRNO);
 			exit(EXIT_FAILURE);
 		}
+	}
 
-		int64_t *arr =
-			(int64_t *)malloc(sizeof(int64_t) * num_cores * num_cores);
-		memset(arr, 0, sizeof(int64_t) * num_cores * num_cores);
+	int32_t n_sweep = args.n_ring_bytes * args.n_burst;
+	result_t *results =
+		(result_t *)malloc(sizeof(result_t) * args.n_stride * n_sweep);
+	if (results == NULL) {
+		LOG_ERROR("failed allocate results");
+		exit(EXIT_FAILURE);
+	}
+	memset(results, 0, sizeof(result_t) * args.n_stride * n_sweep);
 
-		for (int i = 0; i < num_cores; ++i) {
-			for (int j = i + 1; j < num_cores; ++j) {
-				args.producer_core = i;
-				args.consumer_core = j;
-				int64_t middle_val = run_shm_rbuf(&args);
-				arr[num_cores * i + j] = middle_val;
-				arr[num_cores * j + i] = middle_val;
-			}
+	FILE *compare_fp = NULL;
+	char compare_filepath[MUGGLE_MAX_PATH];
+	if (args.n_mode > 1) {
+		snprintf(compare_filepath, sizeof(compare_filepath),
+				 "./c2c_benchmark_reports/"
+				 "summary_shm_rbuf_modes_c%d_to_c%d.csv",
+				 args.producer_core, args.consumer_core);
+		compare_fp = muggle_os_fopen(compare_filepath, "w");
+		if (compare_fp) {
+			fprintf(compare_fp, "stride,pitch,ring_bytes,burst,mode,p50,p99,"
+								"throughput,delta_p50,delta_p99,"
+								"delta_throughput\n");
 		}
+	}
 
-		fprintf(stdout, "      ");
-		for (int i = 0; i < num_cores; ++i) {
-			fprintf(stdout, "%6d", i);
-		}
-		fprintf(stdout, "\n");
-		for (int i = 0; i < num_cores; ++i) {
-			fprintf(stdout, "%6d", i);
-			for (int j = 0; j < num_cores; ++j) {
-				fprintf(stdout, "%6lld", (long long)arr[num_cores * i + j]);
+	for (int32_t i = 0; i < args.n_stride; ++i) {
+		for (int32_t q = 0; q < args.n_ring_bytes; ++q) {
+			for (int32_t m = 0; m < args.n_burst; ++m) {
+				int32_t idx = (i * args.n_ring_bytes + q) * args.n_burst + m;
+				args.stride = args.strides[i];
+				args.ring_bytes = args.ring_bytes_list[q];
+				args.record_per_round = args.bursts[m];
+				print_sweep_title(&args);
+				if (is_matrix) {
+					run_matrix(&args, &noise_args, num_cores);
+				} else if (args.n_mode > 1) {
+					run_compare(&args, &noise_args, compare_fp,
+								&results[idx]);
+				} else {
+					run_single(&args, &noise_args, &results[idx]);
+				}
 			}
-			fprintf(stdout, "\n");
 		}
-	} else {
-		int64_t middle_val = run_shm_rbuf(&args);
-		fprintf(stdout, "%d -> %d: %lld\n", args.producer_core,
-				args.consumer_core, (long long)middle_val);
+	}
+
+	if (!is_matrix && n_sweep > 1) {
+		report_sweep(&args, results);
+	}
+	free(results);
+	if (compare_fp) {
+		fclose(compare_fp);
+		LOG_INFO("generate summary report: %s", compare_filepath);
+	}
+
+	if (args.n_mode == 1 && args.consumer_mode == CONSUMER_MODE_BATCH &&
+		args.batch_size > 1) {
+		fprintf(stdout,
+				"NOTE: batch mode runs on spsc ring, not muggle_shm_ringbuf; "
+				"compare with '-t inplace,batch' for the batching effect\n");
 	}
 
 	return 0;
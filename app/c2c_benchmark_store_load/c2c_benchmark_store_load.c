@@ -1,35 +1,44 @@
 #include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
+#include "c2c_benchmark_noise.h"
+#include "c2c_benchmark_cache.h"
+#include "c2c_benchmark_freq.h"
+
+#define MAX_N_STRIDE 8
 
 typedef struct {
-	union {
-		MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
-		struct {
-			int32_t producer_core;
-			int32_t consumer_core;
-			int32_t total_cnt;
-			int32_t n_samples;
-		};
-	};
-	union {
-		MUGGLE_STRUCT_CACHE_LINE_PADDING(1);
-		muggle_atomic_int v1;
-	};
-	union {
-		MUGGLE_STRUCT_CACHE_LINE_PADDING(2);
-		muggle_atomic_int v2;
-	};
+	int32_t producer_core;
+	int32_t consumer_core;
+	int32_t total_cnt;
+	int32_t n_samples;
+	int32_t noisy;
+	int32_t cache;
+	int32_t cache_only;
+	int32_t cache_expire_sec;
+	uint32_t seed;
+	int32_t stride; //!< bytes between v1 and v2 in current run
+	int32_t n_stride;
+	int32_t strides[MAX_N_STRIDE];
+	int64_t producer_mhz;
+	int64_t consumer_mhz;
+	muggle_atomic_int *v1; //!< page aligned, start of adjacent line pair
+	muggle_atomic_int *v2; //!< v1 + stride bytes
 } args_t;
 
-void parse_args(int argc, char **argv, args_t *args)
+void parse_args(int argc, char **argv, args_t *args,
+				c2c_benchmark_noise_args_t *noise_args)
 {
 	memset(args, 0, sizeof(*args));
+	memset(noise_args, 0, sizeof(*noise_args));
 	args->producer_core = -1;
 	args->consumer_core = -1;
 	args->total_cnt = 10000;
 	args->n_samples = 1;
+	args->seed = (uint32_t)time(NULL);
+	args->n_stride = 0;
 
 	int opt;
-	while ((opt = getopt(argc, argv, "p:c:n:s:h")) != -1) {
+	while ((opt = getopt(argc, argv, "p:c:n:s:S:O:N:R:LCE:Xh")) != -1) {
 		switch (opt) {
 		case 'p': {
 			args->producer_core = atoi(optarg);
@@ -46,6 +55,45 @@ void parse_args(int argc, char **argv, args_t *args)
 				args->n_samples = 1;
 			}
 		} break;
+		case 'S': {
+			char *token;
+			token = strtok(optarg, ",");
+
+			while (token != NULL) {
+				int32_t stride = atoi(token);
+				if (stride < 64 || stride % 64 != 0) {
+					LOG_ERROR("invalid stride: %s, need multiple of 64",
+							  token);
+					exit(EXIT_FAILURE);
+				}
+				args->strides[args->n_stride++] = stride;
+				token = strtok(NULL, ",");
+				if (args->n_stride >= MAX_N_STRIDE) {
+					break;
+				}
+			}
+		} break;
+		case 'O': {
+			args->seed = (uint32_t)strtoul(optarg, NULL, 10);
+		} break;
+		case 'N': {
+			c2c_benchmark_noise_add_spec(noise_args, optarg);
+		} break;
+		case 'R': {
+			c2c_benchmark_set_sched_fifo(atoi(optarg));
+		} break;
+		case 'L': {
+			c2c_benchmark_set_lock_memory(1);
+		} break;
+		case 'C': {
+			args->cache = 1;
+		} break;
+		case 'E': {
+			args->cache_expire_sec = atoi(optarg);
+		} break;
+		case 'X': {
+			args->cache_only = 1;
+		} break;
 		case 'h': {
 			printf("Usage of %s:\n"
 				   "  -p int\n"
@@ -55,13 +103,27 @@ void parse_args(int argc, char **argv, args_t *args)
 				   "  -n int\n"
 				   "    total count\n"
 				   "  -s int\n"
-				   "    number of samples per round"
+				   "    number of samples per round\n"
+				   "  -S int array split with comma\n"
+				   "    bytes between the two shared variables, multiple of\n"
+				   "    64, e.g. 64,128,256 shows adjacent line prefetcher\n"
+				   "    interference; default 64\n"
+				   "  -O int\n"
+				   "    random seed of matrix pair order, 0 is sequential\n"
+				   C2C_BENCHMARK_NOISE_USAGE
+				   C2C_BENCHMARK_PREFLIGHT_USAGE
+				   C2C_BENCHMARK_CACHE_USAGE
 				   "",
 				   argv[0]);
 			exit(EXIT_SUCCESS);
 		} break;
 		}
 	}
+
+	if (args->n_stride == 0) {
+		args->strides[args->n_stride++] = 64;
+	}
+	args->stride = args->strides[0];
 }
 
 muggle_thread_ret_t proc_consumer(void *p)
@@ -82,23 +144,26 @@ muggle_thread_ret_t proc_consumer(void *p)
 	c2c_benchmark_warmup(2);
 
 	// run consumer
+	c2c_benchmark_freq_t freq;
+	c2c_benchmark_freq_begin(&freq, args->consumer_core);
 	if (args->n_samples == 1) {
 		for (int32_t i = 0; i < args->total_cnt; ++i) {
-			while (muggle_atomic_load(&args->v1, muggle_memory_order_acquire) !=
+			while (muggle_atomic_load(args->v1, muggle_memory_order_acquire) !=
 				   i)
 				;
-			muggle_atomic_store(&args->v2, i, muggle_memory_order_release);
+			muggle_atomic_store(args->v2, i, muggle_memory_order_release);
 		}
 	} else {
 		for (int32_t i = 0; i < args->total_cnt; ++i) {
 			for (int32_t n = 0; n < args->n_samples; ++n) {
-				while (muggle_atomic_load(&args->v1,
+				while (muggle_atomic_load(args->v1,
 										  muggle_memory_order_acquire) != n)
 					;
-				muggle_atomic_store(&args->v2, n, muggle_memory_order_release);
+				muggle_atomic_store(args->v2, n, muggle_memory_order_release);
 			}
 		}
 	}
+	args->consumer_mhz = c2c_benchmark_freq_end(&freq);
 
 	return 0;
 }
@@ -119,11 +184,13 @@ void proc_producer(args_t *args, cache_line_data_t *datas)
 	c2c_benchmark_warmup(2);
 
 	// run producer
+	c2c_benchmark_freq_t freq;
+	c2c_benchmark_freq_begin(&freq, args->producer_core);
 	if (args->n_samples == 1) {
 		for (int32_t i = 0; i < args->total_cnt; ++i) {
 			muggle_time_counter_start(&datas[i].tc);
-			muggle_atomic_store(&args->v1, i, muggle_memory_order_release);
-			while (muggle_atomic_load(&args->v2, muggle_memory_order_acquire) !=
+			muggle_atomic_store(args->v1, i, muggle_memory_order_release);
+			while (muggle_atomic_load(args->v2, muggle_memory_order_acquire) !=
 				   i)
 				;
 			muggle_time_counter_end(&datas[i].tc);
@@ -132,25 +199,37 @@ void proc_producer(args_t *args, cache_line_data_t *datas)
 		for (int32_t i = 0; i < args->total_cnt; ++i) {
 			muggle_time_counter_start(&datas[i].tc);
 			for (int32_t n = 0; n < args->n_samples; ++n) {
-				muggle_atomic_store(&args->v1, n, muggle_memory_order_release);
-				while (muggle_atomic_load(&args->v2,
+				muggle_atomic_store(args->v1, n, muggle_memory_order_release);
+				while (muggle_atomic_load(args->v2,
 										  muggle_memory_order_acquire) != n)
 					;
 			}
 			muggle_time_counter_end(&datas[i].tc);
 		}
 	}
+	args->producer_mhz = c2c_benchmark_freq_end(&freq);
 }
 
 int64_t run_store_load(args_t *args)
 {
-	// prepare datas
-	args->v1 = -1;
-	args->v2 = -1;
+	// prepare shared variables, aligned to page so v1 starts a 128 bytes
+	// line pair and stride decides whether v2 shares the pair
+	char *mem = (char *)malloc((size_t)args->stride + 64 + 4096);
+	if (mem == NULL) {
+		return -1;
+	}
+	char *base = (char *)(((uintptr_t)mem + 4095) & ~(uintptr_t)4095);
+	memset(base, 0, (size_t)args->stride + 64);
+	args->v1 = (muggle_atomic_int *)base;
+	args->v2 = (muggle_atomic_int *)(base + args->stride);
+	*args->v1 = -1;
+	*args->v2 = -1;
 
+	// prepare datas
 	cache_line_data_t *datas = (cache_line_data_t *)malloc(
 		sizeof(cache_line_data_t) * args->total_cnt);
 	if (datas == NULL) {
+		free(mem);
 		return -1;
 	}
 	for (int32_t i = 0; i < args->total_cnt; ++i) {
@@ -167,14 +246,230 @@ int64_t run_store_load(args_t *args)
 	// cleanup consumer
 	muggle_thread_join(&th_consumer);
 
-	int64_t middle_val = c2c_benchmark_gen_report("store_load",
-												  args->producer_core,
+	char name[64];
+	if (args->stride == 64) {
+		snprintf(name, sizeof(name), "store_load%s",
+				 args->noisy ? "_noise" : "");
+	} else {
+		snprintf(name, sizeof(name), "store_load_S%d%s", args->stride,
+				 args->noisy ? "_noise" : "");
+	}
+	int64_t middle_val = c2c_benchmark_gen_report(name, args->producer_core,
 												  args->consumer_core, datas,
 												  args->total_cnt, 1);
 	free(datas);
+	free(mem);
+	args->v1 = NULL;
+	args->v2 = NULL;
 	return middle_val / args->n_samples;
 }
 
+typedef struct {
+	args_t *args;
+	int64_t vals[2]; //!< middle value of quiet and noise run
+} pair_run_t;
+
+/**
+ * @brief run pair quiet or under noise, keep frequency of quiet run
+ */
+static void run_pair(void *p, int32_t noisy)
+{
+	pair_run_t *run = (pair_run_t *)p;
+	args_t *args = run->args;
+	int64_t producer_mhz = args->producer_mhz;
+	int64_t consumer_mhz = args->consumer_mhz;
+	args->noisy = noisy;
+	run->vals[noisy] = run_store_load(args);
+	args->noisy = 0;
+	if (noisy) {
+		args->producer_mhz = producer_mhz;
+		args->consumer_mhz = consumer_mhz;
+	}
+}
+
+/**
+ * @brief run quiet, then run again under noise if noise spec exists
+ *
+ * noise_val is -1 if noise skipped
+ *
+ * @return middle value of quiet run
+ */
+int64_t run_with_noise(args_t *args, c2c_benchmark_noise_args_t *noise_args,
+					   int64_t *noise_val)
+{
+	pair_run_t run;
+	run.args = args;
+	run.vals[0] = -1;
+	run.vals[1] = -1;
+	int32_t measured_cores[2] = { args->producer_core, args->consumer_core };
+	c2c_benchmark_noise_run(noise_args, measured_cores, 2, run_pair, &run);
+	if (noise_args->n_spec > 0) {
+		*noise_val = run.vals[1];
+	}
+	return run.vals[0];
+}
+
+/**
+ * @brief parameters that affect result of a pair, key of cache
+ */
+void format_params(args_t *args, c2c_benchmark_noise_args_t *noise_args,
+				   char *buf, size_t size)
+{
+	int offset = snprintf(buf, size, "n=%d,s=%d,S=%d,R=%d,L=%d,noise=",
+						  args->total_cnt, args->n_samples, args->stride,
+						  c2c_benchmark_get_sched_fifo(),
+						  c2c_benchmark_get_lock_memory());
+	for (int32_t i = 0; i < noise_args->n_spec; ++i) {
+		if (offset < 0 || (size_t)offset >= size) {
+			break;
+		}
+		offset += snprintf(buf + offset, size - offset, "%s%s",
+						   i == 0 ? "" : ";", noise_args->specs[i]);
+	}
+}
+
+/**
+ * @brief run all core pairs and print matrix
+ */
+void run_matrix(args_t *args, c2c_benchmark_noise_args_t *noise_args,
+				long num_cores)
+{
+	int64_t *arr =
+		(int64_t *)malloc(sizeof(int64_t) * num_cores * num_cores * 3);
+	memset(arr, 0, sizeof(int64_t) * num_cores * num_cores * 3);
+	int64_t *arr_noise = arr + num_cores * num_cores;
+	int64_t *arr_cycles = arr_noise + num_cores * num_cores;
+
+	int64_t *min_mhz = (int64_t *)malloc(sizeof(int64_t) * num_cores * 2);
+	memset(min_mhz, 0, sizeof(int64_t) * num_cores * 2);
+	int64_t *max_mhz = min_mhz + num_cores;
+
+	int32_t *pairs = (int32_t *)malloc(sizeof(int32_t) * num_cores * num_cores);
+	int32_t n_pair =
+		c2c_benchmark_matrix_pairs((int32_t)num_cores, args->seed, pairs);
+
+	c2c_benchmark_cache_t cache;
+	int32_t use_cache = args->cache || args->cache_only;
+	if (use_cache) {
+		char params[1024];
+		format_params(args, noise_args, params, sizeof(params));
+		if (c2c_benchmark_cache_open(&cache, "store_load", params,
+									 (int32_t)num_cores, 5,
+									 args->cache_expire_sec,
+									 args->cache_only) != 0) {
+			LOG_ERROR("failed open cache");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	int32_t n_missing = 0;
+	for (int32_t k = 0; k < n_pair; ++k) {
+		int32_t i = pairs[k * 2];
+		int32_t j = pairs[k * 2 + 1];
+
+		// vals: middle, noise, cycles, producer MHz, consumer MHz
+		int64_t vals[5] = { 0, 0, 0, 0, 0 };
+		if (use_cache && c2c_benchmark_cache_get(&cache, i, j, vals) == 0) {
+			LOG_INFO("%d -> %d: cached", i, j);
+		} else if (args->cache_only) {
+			++n_missing;
+			continue;
+		} else {
+			args->producer_core = i;
+			args->consumer_core = j;
+			vals[0] = run_with_noise(args, noise_args, &vals[1]);
+			vals[3] = args->producer_mhz;
+			vals[4] = args->consumer_mhz;
+			vals[2] = c2c_benchmark_ns_to_cycles(vals[0],
+												 (vals[3] + vals[4]) / 2);
+			// failed run is not a result, measure it again next time
+			if (use_cache && vals[0] != -1) {
+				c2c_benchmark_cache_put(&cache, i, j, vals);
+			}
+		}
+		arr[num_cores * i + j] = vals[0];
+		arr[num_cores * j + i] = vals[0];
+		arr_noise[num_cores * i + j] = vals[1];
+		arr_noise[num_cores * j + i] = vals[1];
+		arr_cycles[num_cores * i + j] = vals[2];
+		arr_cycles[num_cores * j + i] = vals[2];
+
+		int32_t cores[2] = { i, j };
+		for (int32_t c = 0; c < 2; ++c) {
+			int64_t mhz = vals[3 + c];
+			if (min_mhz[cores[c]] == 0 || mhz < min_mhz[cores[c]]) {
+				min_mhz[cores[c]] = mhz;
+			}
+			if (mhz > max_mhz[cores[c]]) {
+				max_mhz[cores[c]] = mhz;
+			}
+		}
+	}
+	free(pairs);
+
+	if (use_cache) {
+		c2c_benchmark_cache_close(&cache);
+	}
+	if (n_missing > 0) {
+		LOG_WARNING("%d pairs missing in cache, filled with 0", n_missing);
+	}
+
+	if (noise_args->n_spec == 0) {
+		c2c_benchmark_print_matrix(stdout, arr, num_cores);
+	} else {
+		fprintf(stdout, "quiet:\n");
+		c2c_benchmark_print_matrix(stdout, arr, num_cores);
+		fprintf(stdout, "noise:\n");
+		c2c_benchmark_print_matrix(stdout, arr_noise, num_cores);
+		int32_t n_skipped = 0;
+		for (long i = 0; i < num_cores * num_cores; ++i) {
+			if (arr_noise[i] < 0) {
+				++n_skipped;
+			} else {
+				arr_noise[i] -= arr[i];
+			}
+		}
+		fprintf(stdout, "delta:\n");
+		c2c_benchmark_print_matrix(stdout, arr_noise, num_cores);
+		if (n_skipped > 0) {
+			fprintf(stdout,
+					"-1: noise skipped, all noise cores are measured cores\n");
+		}
+	}
+	fprintf(stdout, "cycles:\n");
+	c2c_benchmark_print_matrix(stdout, arr_cycles, num_cores);
+	fprintf(stdout, "frequency:\n");
+	c2c_benchmark_print_freq(stdout, min_mhz, max_mhz, num_cores);
+	free(min_mhz);
+	free(arr);
+}
+
+/**
+ * @brief run single core pair and print result
+ */
+void run_single(args_t *args, c2c_benchmark_noise_args_t *noise_args)
+{
+	int64_t noise_val = 0;
+	int64_t middle_val = run_with_noise(args, noise_args, &noise_val);
+	if (noise_args->n_spec == 0) {
+		fprintf(stdout, "%d -> %d: %lld", args->producer_core,
+				args->consumer_core, (long long)middle_val);
+	} else if (noise_val < 0) {
+		fprintf(stdout, "%d -> %d: quiet %lld, noise skipped",
+				args->producer_core, args->consumer_core,
+				(long long)middle_val);
+	} else {
+		fprintf(stdout, "%d -> %d: quiet %lld, noise %lld, delta %lld",
+				args->producer_core, args->consumer_core,
+				(long long)middle_val, (long long)noise_val,
+				(long long)(noise_val - middle_val));
+	}
+	int64_t cycles = c2c_benchmark_ns_to_cycles(
+		middle_val, (args->producer_mhz + args->consumer_mhz) / 2);
+	fprintf(stdout, ", %lld cycles, %lld/%lld MHz\n", (long long)cycles,
+			(long long)args->producer_mhz, (long long)args->consumer_mhz);
+}
+
 int main(int argc, char *argv[])
 {
 	// initialize log
@@ -186,50 +481,53 @@ int main(int argc, char *argv[])
 	}
 
 	args_t args;
-	parse_args(argc, argv, &args);
+	c2c_benchmark_noise_args_t noise_args;
+	parse_args(argc, argv, &args, &noise_args);
 	LOG_INFO("----------------");
 	LOG_INFO("producer_core: %d", args.producer_core);
 	LOG_INFO("consumer_core: %d", args.consumer_core);
 	LOG_INFO("total_cnt: %d", args.total_cnt);
+	LOG_INFO("seed: %u", args.seed);
+	for (int32_t i = 0; i < args.n_stride; ++i) {
+		LOG_INFO("stride[%d]: %d", i, args.strides[i]);
+	}
+	LOG_INFO("cache: %d", args.cache);
+	LOG_INFO("cache_only: %d", args.cache_only);
+	LOG_INFO("cache_expire_sec: %d", args.cache_expire_sec);
+	for (int32_t i = 0; i < noise_args.n_spec; ++i) {
+		LOG_INFO("noise[%d]: %s", i, noise_args.specs[i]);
+	}
 	LOG_INFO("----------------");
 
-	if (args.producer_core == -1 || args.producer_core == -1) {
-		long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (args.producer_core == -1 || args.consumer_core == -1) {
+		if (!args.cache_only) {
+			c2c_benchmark_preflight("store_load", NULL, 0);
+		}
+	} else {
+		int32_t cores[2] = { args.producer_core, args.consumer_core };
+		c2c_benchmark_preflight("store_load", cores, 2);
+	}
+
+	int32_t is_matrix = args.producer_core == -1 || args.consumer_core == -1;
+	long num_cores = 0;
+	if (is_matrix) {
+		num_cores = sysconf(_SC_NPROCESSORS_ONLN);
 		if (num_cores == -1) {
 			LOG_ERROR("failed get core numbers: %d", MUGGLE_EVENT_LAST_ERRNO);
 			exit(EXIT_FAILURE);
 		}
+	}
 
-		int64_t *arr =
-			(int64_t *)malloc(sizeof(int64_t) * num_cores * num_cores);
-		memset(arr, 0, sizeof(int64_t) * num_cores * num_cores);
-
-		for (int i = 0; i < num_cores; ++i) {
-			for (int j = i + 1; j < num_cores; ++j) {
-				args.producer_core = i;
-				args.consumer_core = j;
-				int64_t middle_val = run_store_load(&args);
-				arr[num_cores * i + j] = middle_val;
-				arr[num_cores * j + i] = middle_val;
-			}
-		}
-
-		fprintf(stdout, "      ");
-		for (int i = 0; i < num_cores; ++i) {
-			fprintf(stdout, "%6d", i);
+	for (int32_t i = 0; i < args.n_stride; ++i) {
+		args.stride = args.strides[i];
+		if (args.n_stride > 1) {
+			fprintf(stdout, "stride %d:\n", args.stride);
 		}
-		fprintf(stdout, "\n");
-		for (int i = 0; i < num_cores; ++i) {
-			fprintf(stdout, "%6d", i);
-			for (int j = 0; j < num_cores; ++j) {
-				fprintf(stdout, "%6lld", (long long)arr[num_cores * i + j]);
-			}
-			fprintf(stdout, "\n");
+		if (is_matrix) {
+			run_matrix(&args, &noise_args, num_cores);
+		} else {
+			run_single(&args, &noise_args);
 		}
-	} else {
-		int64_t middle_val = run_store_load(&args);
-		fprintf(stdout, "%d -> %d: %lld\n", args.producer_core,
-				args.consumer_core, (long long)middle_val);
 	}
 
 	return 0;
@@ -1,4 +1,5 @@
 #include "c2c_benchmark.h"
+#include "c2c_benchmark_preflight.h"
 
 static void write_statistics_head(FILE *fp)
 {
@@ -31,6 +32,20 @@ int64_t c2c_benchmark_gen_report(const char *name, int32_t producer_core,
 								 int32_t consumer_core,
 								 cache_line_data_t *datas, size_t total_cnt,
 								 int32_t is_rtt)
+{
+	char producer_cores[16];
+	char consumer_cores[16];
+	snprintf(producer_cores, sizeof(producer_cores), "%d", producer_core);
+	snprintf(consumer_cores, sizeof(consumer_cores), "%d", consumer_core);
+	return c2c_benchmark_gen_report_cores(name, producer_cores, consumer_cores,
+										  datas, total_cnt, is_rtt);
+}
+
+int64_t c2c_benchmark_gen_report_cores(const char *name,
+									   const char *producer_cores,
+									   const char *consumer_cores,
+									   cache_line_data_t *datas,
+									   size_t total_cnt, int32_t is_rtt)
 {
 	// get 1/2 rtt c2c elapsed
 	int64_t *elapseds = (int64_t *)malloc(sizeof(int64_t) * total_cnt);
@@ -47,8 +62,8 @@ int64_t c2c_benchmark_gen_report(const char *name, int32_t producer_core,
 #else
 	char records_filepath[MUGGLE_MAX_PATH];
 	snprintf(records_filepath, sizeof(records_filepath),
-			 "./c2c_benchmark_reports/record_%s_c%d_to_c%d.csv", name,
-			 producer_core, consumer_core);
+			 "./c2c_benchmark_reports/record_%s_c%s_to_c%s.csv", name,
+			 producer_cores, consumer_cores);
 	FILE *fp = muggle_os_fopen(records_filepath, "w");
 	fprintf(fp, "idx,start,end,elapsed\n");
 	for (size_t i = 0; i < total_cnt; ++i) {
@@ -65,8 +80,8 @@ int64_t c2c_benchmark_gen_report(const char *name, int32_t producer_core,
 
 	char statistics_filepath[MUGGLE_MAX_PATH];
 	snprintf(statistics_filepath, sizeof(statistics_filepath),
-			 "./c2c_benchmark_reports/statistics_%s_c%d_to_c%d.csv", name,
-			 producer_core, consumer_core);
+			 "./c2c_benchmark_reports/statistics_%s_c%s_to_c%s.csv", name,
+			 producer_cores, consumer_cores);
 	fp = muggle_os_fopen(statistics_filepath, "w");
 	fprintf(fp, "sort_by,");
 	write_statistics_head(fp);
@@ -84,7 +99,164 @@ int64_t c2c_benchmark_gen_report(const char *name, int32_t producer_core,
 	return middle_val;
 }
 
-int c2c_benchmark_bind_core(int32_t core)
+const char *c2c_benchmark_core_list_str(const int32_t *cores, int32_t n,
+										char *buf, size_t size)
+{
+	size_t offset = 0;
+	buf[0] = '\0';
+	for (int32_t i = 0; i < n; ++i) {
+		int ret = snprintf(buf + offset, size - offset, i == 0 ? "%d" : "-%d",
+						   cores[i]);
+		if (ret < 0 || (size_t)ret >= size - offset) {
+			break;
+		}
+		offset += (size_t)ret;
+	}
+	return buf;
+}
+
+int64_t c2c_benchmark_percentile(cache_line_data_t *datas, size_t total_cnt,
+								 double p)
+{
+	if (total_cnt == 0) {
+		return -1;
+	}
+
+	int64_t *elapseds = (int64_t *)malloc(sizeof(int64_t) * total_cnt);
+	if (elapseds == NULL) {
+		return -1;
+	}
+	for (size_t i = 0; i < total_cnt; ++i) {
+		elapseds[i] = muggle_time_counter_interval_ns(&datas[i].tc);
+	}
+	qsort(elapseds, total_cnt, sizeof(int64_t), compare_int64);
+
+	size_t idx = (size_t)((p / 100.0) * total_cnt);
+	if (idx >= total_cnt) {
+		idx = total_cnt - 1;
+	}
+	int64_t val = elapseds[idx];
+	free(elapseds);
+
+	return val;
+}
+
+double c2c_benchmark_throughput(cache_line_data_t *datas, size_t total_cnt)
+{
+	if (total_cnt == 0) {
+		return 0.0;
+	}
+
+	muggle_time_counter_t tc = datas[0].tc;
+	for (size_t i = 1; i < total_cnt; ++i) {
+		const muggle_time_counter_t *data = &datas[i].tc;
+		if (data->start_ts.tv_sec < tc.start_ts.tv_sec ||
+			(data->start_ts.tv_sec == tc.start_ts.tv_sec &&
+			 data->start_ts.tv_nsec < tc.start_ts.tv_nsec)) {
+			tc.start_ts = data->start_ts;
+		}
+		if (data->end_ts.tv_sec > tc.end_ts.tv_sec ||
+			(data->end_ts.tv_sec == tc.end_ts.tv_sec &&
+			 data->end_ts.tv_nsec > tc.end_ts.tv_nsec)) {
+			tc.end_ts = data->end_ts;
+		}
+	}
+
+	int64_t elapsed = muggle_time_counter_interval_ns(&tc);
+	if (elapsed <= 0) {
+		return 0.0;
+	}
+	return (double)total_cnt * 1000000000.0 / elapsed;
+}
+
+void c2c_benchmark_print_matrix(FILE *fp, const int64_t *arr,
+								int32_t num_cores)
+{
+	fprintf(fp, "      ");
+	for (int i = 0; i < num_cores; ++i) {
+		fprintf(fp, "%6d", i);
+	}
+	fprintf(fp, "\n");
+	for (int i = 0; i < num_cores; ++i) {
+		fprintf(fp, "%6d", i);
+		for (int j = 0; j < num_cores; ++j) {
+			fprintf(fp, "%6lld", (long long)arr[num_cores * i + j]);
+		}
+		fprintf(fp, "\n");
+	}
+}
+
+int32_t c2c_benchmark_matrix_pairs(int32_t num_cores, uint32_t seed,
+								   int32_t *pairs)
+{
+	int32_t n_pair = 0;
+	for (int32_t i = 0; i < num_cores; ++i) {
+		for (int32_t j = i + 1; j < num_cores; ++j) {
+			pairs[n_pair * 2] = i;
+			pairs[n_pair * 2 + 1] = j;
+			++n_pair;
+		}
+	}
+	if (seed == 0) {
+		return n_pair;
+	}
+
+	// Fisher-Yates shuffle with xorshift32, same order for the same seed;
+	// scramble seed first, small seeds give poor first outputs
+	uint32_t x = seed * 2654435761u;
+	if (x == 0) {
+		x = 1;
+	}
+	for (int32_t k = 0; k < 8; ++k) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+	}
+	for (int32_t k = n_pair - 1; k > 0; --k) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		int32_t r = (int32_t)(x % (uint32_t)(k + 1));
+		int32_t i = pairs[k * 2];
+		int32_t j = pairs[k * 2 + 1];
+		pairs[k * 2] = pairs[r * 2];
+		pairs[k * 2 + 1] = pairs[r * 2 + 1];
+		pairs[r * 2] = i;
+		pairs[r * 2 + 1] = j;
+	}
+	return n_pair;
+}
+
+int32_t c2c_benchmark_parse_cpu_list(const char *s, int32_t *cores,
+									 int32_t max_n)
+{
+	int32_t n = 0;
+	char *token = (char *)s;
+	while (token && n < max_n) {
+		while (*token == ' ' || *token == '\t') {
+			++token;
+		}
+		if (*token < '0' || *token > '9') {
+			break;
+		}
+
+		int32_t first = (int32_t)strtol(token, &token, 10);
+		int32_t last = first;
+		if (*token == '-') {
+			last = (int32_t)strtol(token + 1, &token, 10);
+		}
+		for (int32_t c = first; c <= last && n < max_n; ++c) {
+			cores[n++] = c;
+		}
+		if (*token != ',') {
+			break;
+		}
+		++token;
+	}
+	return n;
+}
+
+int c2c_benchmark_set_affinity(int32_t core)
 {
 	muggle_cpu_mask_t mask;
 	muggle_cpu_mask_zero(&mask);
@@ -92,6 +264,23 @@ int c2c_benchmark_bind_core(int32_t core)
 	return muggle_cpu_set_thread_affinity(0, &mask);
 }
 
+int c2c_benchmark_bind_core(int32_t core)
+{
+	int ret = c2c_benchmark_set_affinity(core);
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = c2c_benchmark_apply_sched();
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed set SCHED_FIFO on CPU core #%d, err=%s", core,
+				  errmsg);
+	}
+	return 0;
+}
+
 void c2c_benchmark_warmup(int32_t ms)
 {
 	muggle_time_counter_t warmup_tc;
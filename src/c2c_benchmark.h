@@ -44,7 +44,96 @@ int64_t c2c_benchmark_gen_report(const char *name, int32_t producer_core,
 							   int32_t is_rtt);
 
 /**
- * @brief bind core
+ * @brief generate report, with producer/consumer described by core list
+ *
+ * @param name            benchmark name
+ * @param producer_cores  producer bind cores, e.g. "0-1-2"
+ * @param consumer_cores  consumer bind cores, e.g. "3"
+ * @param tc_arr          time counter array
+ * @param total_cnt       total count
+ * @param is_rtt          is rtt
+ *
+ * @RETURN middle value of elapsed
+ */
+int64_t c2c_benchmark_gen_report_cores(const char *name,
+									   const char *producer_cores,
+									   const char *consumer_cores,
+									   cache_line_data_t *datas,
+									   size_t total_cnt, int32_t is_rtt);
+
+/**
+ * @brief format core list, e.g. {0, 1, 2} -> "0-1-2"
+ *
+ * @param cores  core array
+ * @param n      number of cores
+ * @param buf    output buffer
+ * @param size   size of output buffer
+ *
+ * @return buf
+ */
+const char *c2c_benchmark_core_list_str(const int32_t *cores, int32_t n,
+										char *buf, size_t size);
+
+/**
+ * @brief percentile of elapsed
+ *
+ * @param datas      time counter array
+ * @param total_cnt  total count
+ * @param p          percentile, in [0, 100]
+ *
+ * @return elapsed nanoseconds at percentile p
+ */
+int64_t c2c_benchmark_percentile(cache_line_data_t *datas, size_t total_cnt,
+								 double p);
+
+/**
+ * @brief throughput of records, from the first start to the last end
+ *
+ * @param datas      time counter array
+ * @param total_cnt  total count
+ *
+ * @return messages per second
+ */
+double c2c_benchmark_throughput(cache_line_data_t *datas, size_t total_cnt);
+
+/**
+ * @brief print core to core matrix
+ *
+ * @param fp         output file
+ * @param arr        n x n values, arr[n * i + j] is value of core i to core j
+ * @param num_cores  number of cores
+ */
+void c2c_benchmark_print_matrix(FILE *fp, const int64_t *arr,
+								int32_t num_cores);
+
+/**
+ * @brief core pairs (i, j), i < j, of matrix sweep in random order, so
+ * frequency drift during the sweep doesn't show up as a topology pattern
+ *
+ * @param num_cores  number of cores
+ * @param seed       random seed, 0 keeps sequential order
+ * @param pairs      output pairs, num_cores * (num_cores - 1) elements,
+ *                   pairs[2k] is i and pairs[2k+1] is j of k-th pair
+ *
+ * @return number of pairs
+ */
+int32_t c2c_benchmark_matrix_pairs(int32_t num_cores, uint32_t seed,
+								   int32_t *pairs);
+
+/**
+ * @brief parse cpu list in sysfs format, e.g. "0-3,8,10-11"
+ *
+ * @param s      cpu list string
+ * @param cores  output cores
+ * @param max_n  capacity of cores
+ *
+ * @return number of cores
+ */
+int32_t c2c_benchmark_parse_cpu_list(const char *s, int32_t *cores,
+									 int32_t max_n);
+
+/**
+ * @brief bind calling thread to core, without touching scheduling policy
  *
  * @param core  core number
  *
@@ -52,6 +141,20 @@ int64_t c2c_benchmark_gen_report(const char *name, int32_t producer_core,
  *     0 - success
  *     otherwise - errno
  */
+int c2c_benchmark_set_affinity(int32_t core);
+
+/**
+ * @brief bind core, and apply scheduling policy set by
+ * c2c_benchmark_set_sched_fifo
+ *
+ * Failure of scheduling policy is logged here and doesn't fail binding
+ *
+ * @param core  core number
+ *
+ * @return
+ *     0 - success
+ *     otherwise - errno of setting affinity
+ */
 int c2c_benchmark_bind_core(int32_t core);
 
 /**
@@ -0,0 +1,123 @@
+#include "c2c_benchmark_bcast.h"
+
+#define BCAST_SEQ_BUSY INT32_MIN
+
+size_t c2c_benchmark_bcast_mem_size(uint32_t capacity, uint32_t n_reader)
+{
+	return sizeof(c2c_benchmark_bcast_hdr_t) +
+		   sizeof(c2c_benchmark_bcast_cursor_t) * n_reader +
+		   sizeof(c2c_benchmark_bcast_slot_t) * capacity;
+}
+
+void c2c_benchmark_bcast_attach(c2c_benchmark_bcast_t *ring, void *mem)
+{
+	memset(ring, 0, sizeof(*ring));
+	ring->hdr = (c2c_benchmark_bcast_hdr_t *)mem;
+	ring->cursors = (c2c_benchmark_bcast_cursor_t *)(ring->hdr + 1);
+	ring->slots =
+		(c2c_benchmark_bcast_slot_t *)(ring->cursors + ring->hdr->n_reader);
+}
+
+int c2c_benchmark_bcast_init(c2c_benchmark_bcast_t *ring, void *mem,
+							 uint32_t capacity, uint32_t n_reader,
+							 int32_t blocking)
+{
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+		LOG_ERROR("broadcast ring capacity must be power of 2");
+		return -1;
+	}
+	if (n_reader == 0 || n_reader > C2C_BENCHMARK_BCAST_MAX_READER) {
+		LOG_ERROR("invalid number of broadcast ring readers: %u", n_reader);
+		return -1;
+	}
+
+	c2c_benchmark_bcast_hdr_t *hdr = (c2c_benchmark_bcast_hdr_t *)mem;
+	memset(hdr, 0, c2c_benchmark_bcast_mem_size(capacity, n_reader));
+	hdr->capacity = capacity;
+	hdr->n_reader = n_reader;
+	hdr->blocking = blocking;
+
+	c2c_benchmark_bcast_attach(ring, mem);
+
+	// slot k holds sequence of previous lap, so no reader sees it as ready
+	for (uint32_t k = 0; k < capacity; ++k) {
+		ring->slots[k].seq = (int)(k - capacity);
+	}
+	muggle_atomic_store(&hdr->w_seq, 0, muggle_memory_order_release);
+
+	return 0;
+}
+
+int c2c_benchmark_bcast_write(c2c_benchmark_bcast_t *ring, int32_t v0,
+							  int32_t v1)
+{
+	c2c_benchmark_bcast_hdr_t *hdr = ring->hdr;
+	uint32_t s = ring->w_local;
+
+	if (hdr->blocking && s - ring->w_cached_min >= hdr->capacity) {
+		uint32_t max_lag = 0;
+		for (uint32_t i = 0; i < hdr->n_reader; ++i) {
+			uint32_t c = (uint32_t)muggle_atomic_load(
+				&ring->cursors[i].cursor, muggle_memory_order_acquire);
+			if (s - c > max_lag) {
+				max_lag = s - c;
+			}
+		}
+		ring->w_cached_min = s - max_lag;
+		if (max_lag >= hdr->capacity) {
+			return -1;
+		}
+	}
+
+	// mark busy first, so reader of the previous lap sees the overwrite
+	c2c_benchmark_bcast_slot_t *slot = &ring->slots[s & (hdr->capacity - 1)];
+	muggle_atomic_store(&slot->seq, BCAST_SEQ_BUSY,
+						muggle_memory_order_relaxed);
+	muggle_atomic_store(&slot->v0, v0, muggle_memory_order_release);
+	muggle_atomic_store(&slot->v1, v1, muggle_memory_order_release);
+	muggle_atomic_store(&slot->seq, (int)s, muggle_memory_order_release);
+
+	ring->w_local = s + 1;
+	muggle_atomic_store(&hdr->w_seq, (int)ring->w_local,
+						muggle_memory_order_release);
+
+	return 0;
+}
+
+int c2c_benchmark_bcast_read(c2c_benchmark_bcast_t *ring, uint32_t reader,
+							 int32_t *v0, int32_t *v1, uint32_t *n_lost)
+{
+	c2c_benchmark_bcast_hdr_t *hdr = ring->hdr;
+	muggle_atomic_int *p_cursor = &ring->cursors[reader].cursor;
+	uint32_t r = (uint32_t)muggle_atomic_load(p_cursor,
+											  muggle_memory_order_relaxed);
+	c2c_benchmark_bcast_slot_t *slot = &ring->slots[r & (hdr->capacity - 1)];
+
+	int s1 = muggle_atomic_load(&slot->seq, muggle_memory_order_acquire);
+	if (s1 == (int)r) {
+		// acquire loads keep the second seq load after the data loads
+		*v0 = muggle_atomic_load(&slot->v0, muggle_memory_order_acquire);
+		*v1 = muggle_atomic_load(&slot->v1, muggle_memory_order_acquire);
+		int s2 = muggle_atomic_load(&slot->seq, muggle_memory_order_acquire);
+		if (s2 == s1) {
+			muggle_atomic_store(p_cursor, (int)(r + 1),
+								muggle_memory_order_release);
+			return C2C_BENCHMARK_BCAST_OK;
+		}
+	} else if (s1 == BCAST_SEQ_BUSY) {
+		uint32_t w = (uint32_t)muggle_atomic_load(
+			&hdr->w_seq, muggle_memory_order_acquire);
+		if (w - r < hdr->capacity) {
+			return C2C_BENCHMARK_BCAST_EMPTY;
+		}
+	} else if ((int32_t)((uint32_t)s1 - r) < 0) {
+		return C2C_BENCHMARK_BCAST_EMPTY;
+	}
+
+	// lapped, skip to writer position
+	uint32_t w = (uint32_t)muggle_atomic_load(&hdr->w_seq,
+											  muggle_memory_order_acquire);
+	*n_lost = w - r;
+	muggle_atomic_store(p_cursor, (int)w, muggle_memory_order_release);
+	return C2C_BENCHMARK_BCAST_LAPPED;
+}
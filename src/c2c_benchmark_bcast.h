@@ -0,0 +1,149 @@
+/******************************************************************************
+ *  @file         c2c_benchmark_bcast.h
+ *  @author       Muggle Wei
+ *  @email        mugglewei@gmail.com
+ *  @date         2025-08-02
+ *  @copyright    Copyright 2025 Muggle Wei
+ *  @license      MIT License
+ *  @brief        c2c benchmark single writer broadcast ring
+ *****************************************************************************/
+
+#ifndef C2C_BENCHMARK_BCAST_H_
+#define C2C_BENCHMARK_BCAST_H_
+
+#include "c2c_benchmark.h"
+
+EXTERN_C_BEGIN
+
+#define C2C_BENCHMARK_BCAST_MAX_READER 64
+
+#define C2C_BENCHMARK_BCAST_OK 0 //!< read success
+#define C2C_BENCHMARK_BCAST_EMPTY 1 //!< no new slot
+#define C2C_BENCHMARK_BCAST_LAPPED 2 //!< slot overwritten, reader resync
+
+/**
+ * @brief ring header, at the beginning of ring memory
+ */
+typedef struct {
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+		struct {
+			uint32_t capacity;
+			uint32_t n_reader;
+			int32_t blocking;
+		};
+	};
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(1);
+		muggle_atomic_int w_seq; //!< next sequence to write
+	};
+} c2c_benchmark_bcast_hdr_t;
+
+/**
+ * @brief reader cursor, next sequence the reader will read
+ */
+typedef union {
+	MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+	muggle_atomic_int cursor;
+} c2c_benchmark_bcast_cursor_t;
+
+/**
+ * @brief slot, seq is the sequence stored in it, INT32_MIN while being
+ * written
+ */
+typedef union {
+	MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+	struct {
+		muggle_atomic_int seq;
+		muggle_atomic_int v0;
+		muggle_atomic_int v1;
+	};
+} c2c_benchmark_bcast_slot_t;
+
+/**
+ * @brief single writer, multiple reader broadcast ring
+ *
+ * Every reader sees every message and keeps its own cursor. In blocking
+ * mode writer waits for the slowest reader cursor; otherwise writer never
+ * waits and a reader that falls a full ring behind is lapped: it detects
+ * the overwritten slot from the slot sequence, skips to the writer
+ * position and reports the lost count.
+ *
+ * The ring lives in caller provided memory, e.g. muggle_shm_open, so
+ * readers may be in other processes.
+ */
+typedef struct {
+	c2c_benchmark_bcast_hdr_t *hdr;
+	c2c_benchmark_bcast_cursor_t *cursors;
+	c2c_benchmark_bcast_slot_t *slots;
+	uint32_t w_local; //!< writer local sequence
+	uint32_t w_cached_min; //!< writer cached slowest reader cursor
+} c2c_benchmark_bcast_t;
+
+/**
+ * @brief bytes of ring memory
+ *
+ * @param capacity  number of slots, power of 2
+ * @param n_reader  number of readers
+ *
+ * @return bytes
+ */
+size_t c2c_benchmark_bcast_mem_size(uint32_t capacity, uint32_t n_reader);
+
+/**
+ * @brief format ring memory, called by writer before readers attach
+ *
+ * @param ring      ring
+ * @param mem       ring memory, c2c_benchmark_bcast_mem_size bytes, cache
+ *                  line aligned
+ * @param capacity  number of slots, power of 2
+ * @param n_reader  number of readers
+ * @param blocking  writer waits slowest reader or overwrites
+ *
+ * @return
+ *     0 - success
+ *     otherwise - failed
+ */
+int c2c_benchmark_bcast_init(c2c_benchmark_bcast_t *ring, void *mem,
+							 uint32_t capacity, uint32_t n_reader,
+							 int32_t blocking);
+
+/**
+ * @brief attach formatted ring memory
+ *
+ * @param ring  ring
+ * @param mem   ring memory
+ */
+void c2c_benchmark_bcast_attach(c2c_benchmark_bcast_t *ring, void *mem);
+
+/**
+ * @brief writer publish a message
+ *
+ * @param ring  ring
+ * @param v0    message word 0
+ * @param v1    message word 1
+ *
+ * @return
+ *     0 - success
+ *     otherwise - ring is full in blocking mode, retry later
+ */
+int c2c_benchmark_bcast_write(c2c_benchmark_bcast_t *ring, int32_t v0,
+							  int32_t v1);
+
+/**
+ * @brief reader read next message
+ *
+ * @param ring    ring
+ * @param reader  reader index
+ * @param v0      output message word 0
+ * @param v1      output message word 1
+ * @param n_lost  output number of skipped sequences when lapped
+ *
+ * @return C2C_BENCHMARK_BCAST_OK, _EMPTY or _LAPPED
+ */
+int c2c_benchmark_bcast_read(c2c_benchmark_bcast_t *ring, uint32_t reader,
+							 int32_t *v0, int32_t *v1, uint32_t *n_lost);
+
+EXTERN_C_END
+
+#endif // !C2C_BENCHMARK_BCAST_H_
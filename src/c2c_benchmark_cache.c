@@ -0,0 +1,340 @@
+#include "c2c_benchmark_cache.h"
+#include <time.h>
+#if MUGGLE_PLATFORM_LINUX
+	#include <sys/utsname.h>
+#endif
+
+#define CACHE_LINE_SIZE 16384
+
+static uint64_t cache_hash(const char *s, uint64_t h)
+{
+	// FNV-1a
+	for (; *s; ++s) {
+		h ^= (uint64_t)(unsigned char)*s;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+#if MUGGLE_PLATFORM_LINUX
+
+/**
+ * @brief find value of first "key : value" line in /proc/cpuinfo
+ */
+static void cache_cpuinfo(const char *key, char *buf, size_t size)
+{
+	snprintf(buf, size, "unknown");
+	FILE *fp = fopen("/proc/cpuinfo", "r");
+	if (fp == NULL) {
+		return;
+	}
+
+	char line[1024];
+	size_t key_len = strlen(key);
+	while (fgets(line, sizeof(line), fp)) {
+		if (strncmp(line, key, key_len) != 0) {
+			continue;
+		}
+		char *p = strchr(line, ':');
+		if (p == NULL) {
+			continue;
+		}
+		p += 1;
+		while (*p == ' ' || *p == '\t') {
+			++p;
+		}
+		size_t len = strlen(p);
+		while (len > 0 && (p[len - 1] == '\n' || p[len - 1] == '\r')) {
+			p[--len] = '\0';
+		}
+		snprintf(buf, size, "%s", p);
+		break;
+	}
+	fclose(fp);
+}
+
+static int64_t cache_read_int(const char *filepath)
+{
+	FILE *fp = fopen(filepath, "r");
+	if (fp == NULL) {
+		return -1;
+	}
+	long long v = -1;
+	if (fscanf(fp, "%lld", &v) != 1) {
+		v = -1;
+	}
+	fclose(fp);
+	return (int64_t)v;
+}
+
+#endif
+
+const char *c2c_benchmark_cache_fingerprint(char *buf, size_t size)
+{
+	long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+#if MUGGLE_PLATFORM_LINUX
+	char model[256];
+	char microcode[64];
+	cache_cpuinfo("model name", model, sizeof(model));
+	cache_cpuinfo("microcode", microcode, sizeof(microcode));
+
+	char kernel[512];
+	struct utsname uts;
+	if (uname(&uts) == 0) {
+		snprintf(kernel, sizeof(kernel), "%s %s", uts.release, uts.version);
+	} else {
+		snprintf(kernel, sizeof(kernel), "unknown");
+	}
+
+	// topology: package, die and core id of each core, hashed
+	uint64_t topo = 14695981039346656037ULL;
+	for (long i = 0; i < num_cores; ++i) {
+		const char *ids[] = { "physical_package_id", "die_id", "core_id" };
+		char item[128];
+		for (size_t k = 0; k < sizeof(ids) / sizeof(ids[0]); ++k) {
+			char filepath[MUGGLE_MAX_PATH];
+			snprintf(filepath, sizeof(filepath),
+					 "/sys/devices/system/cpu/cpu%ld/topology/%s", i, ids[k]);
+			snprintf(item, sizeof(item), "%ld:%s=%lld;", i, ids[k],
+					 (long long)cache_read_int(filepath));
+			topo = cache_hash(item, topo);
+		}
+	}
+
+	snprintf(buf, size,
+			 "cpu=%s; microcode=%s; kernel=%s; cores=%ld; topology=%016llx",
+			 model, microcode, kernel, num_cores, (unsigned long long)topo);
+#else
+	snprintf(buf, size, "cores=%ld", num_cores);
+#endif
+
+	return buf;
+}
+
+/**
+ * @brief load pairs from cache file
+ *
+ * @return
+ *     0 - loaded or not exists
+ *     -1 - header mismatch
+ */
+static int cache_load(c2c_benchmark_cache_t *cache, const char *fingerprint,
+					  const char *params)
+{
+	FILE *fp = fopen(cache->filepath, "r");
+	if (fp == NULL) {
+		return 0;
+	}
+
+	char *line = (char *)malloc(CACHE_LINE_SIZE);
+	if (line == NULL) {
+		fclose(fp);
+		return -1;
+	}
+
+	int ret = 0;
+	int32_t n_loaded = 0;
+	int32_t line_no = 0;
+	while (fgets(line, CACHE_LINE_SIZE, fp)) {
+		size_t len = strlen(line);
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+			line[--len] = '\0';
+		}
+		++line_no;
+
+		if (line_no == 1) {
+			if (strncmp(line, "# fingerprint: ", 15) != 0 ||
+				strcmp(line + 15, fingerprint) != 0) {
+				ret = -1;
+				break;
+			}
+			continue;
+		}
+		if (line_no == 2) {
+			if (strncmp(line, "# params: ", 10) != 0 ||
+				strcmp(line + 10, params) != 0) {
+				ret = -1;
+				break;
+			}
+			continue;
+		}
+		if (line[0] == '#' || line[0] == '\0') {
+			continue;
+		}
+
+		// i,j,ts,v0,v1,...
+		char *endptr = line;
+		long long i = strtoll(endptr, &endptr, 10);
+		if (*endptr++ != ',') {
+			continue;
+		}
+		long long j = strtoll(endptr, &endptr, 10);
+		if (*endptr++ != ',') {
+			continue;
+		}
+		long long ts = strtoll(endptr, &endptr, 10);
+		if (i < 0 || j < 0 || i >= cache->num_cores ||
+			j >= cache->num_cores) {
+			continue;
+		}
+
+		int64_t vals[C2C_BENCHMARK_CACHE_MAX_VAL];
+		int32_t n = 0;
+		while (n < cache->n_val && *endptr == ',') {
+			endptr += 1;
+			vals[n++] = (int64_t)strtoll(endptr, &endptr, 10);
+		}
+		if (n != cache->n_val) {
+			continue;
+		}
+
+		// later lines override earlier lines of the same pair
+		size_t idx = (size_t)cache->num_cores * i + j;
+		memcpy(cache->vals + idx * cache->n_val, vals,
+			   sizeof(int64_t) * cache->n_val);
+		cache->ts[idx] = ts;
+		++n_loaded;
+	}
+
+	free(line);
+	fclose(fp);
+
+	if (ret == 0) {
+		LOG_INFO("load %d cached pairs from %s", n_loaded, cache->filepath);
+	}
+	return ret;
+}
+
+int c2c_benchmark_cache_open(c2c_benchmark_cache_t *cache, const char *name,
+							 const char *params, int32_t num_cores,
+							 int32_t n_val, int64_t expire_sec,
+							 int32_t readonly)
+{
+	memset(cache, 0, sizeof(*cache));
+	if (n_val < 1 || n_val > C2C_BENCHMARK_CACHE_MAX_VAL || num_cores < 1) {
+		LOG_ERROR("invalid cache arguments");
+		return -1;
+	}
+	cache->num_cores = num_cores;
+	cache->n_val = n_val;
+	cache->expire_sec = expire_sec;
+
+	size_t n_pair = (size_t)num_cores * num_cores;
+	cache->vals = (int64_t *)malloc(sizeof(int64_t) * n_pair * n_val);
+	cache->ts = (int64_t *)malloc(sizeof(int64_t) * n_pair);
+	if (cache->vals == NULL || cache->ts == NULL) {
+		LOG_ERROR("failed allocate cache");
+		c2c_benchmark_cache_close(cache);
+		return -1;
+	}
+	memset(cache->vals, 0, sizeof(int64_t) * n_pair * n_val);
+	memset(cache->ts, 0, sizeof(int64_t) * n_pair);
+
+	char fingerprint[2048];
+	c2c_benchmark_cache_fingerprint(fingerprint, sizeof(fingerprint));
+	uint64_t h = cache_hash(fingerprint, 14695981039346656037ULL);
+	h = cache_hash("\n", h);
+	h = cache_hash(params, h);
+	snprintf(cache->filepath, sizeof(cache->filepath),
+			 "./c2c_benchmark_reports/cache_%s_%016llx.csv", name,
+			 (unsigned long long)h);
+	LOG_INFO("cache file: %s", cache->filepath);
+	LOG_INFO("cache fingerprint: %s", fingerprint);
+	LOG_INFO("cache params: %s", params);
+
+	int mismatch = cache_load(cache, fingerprint, params) != 0;
+	if (mismatch) {
+		LOG_WARNING("cache header mismatch, discard %s", cache->filepath);
+		memset(cache->ts, 0, sizeof(int64_t) * n_pair);
+	}
+
+	if (readonly) {
+		return 0;
+	}
+
+	FILE *fp_exists = fopen(cache->filepath, "r");
+	int exists = fp_exists != NULL;
+	if (fp_exists) {
+		fclose(fp_exists);
+	}
+
+	cache->fp = muggle_os_fopen(cache->filepath,
+								(exists && !mismatch) ? "a" : "w");
+	if (cache->fp == NULL) {
+		LOG_ERROR("failed open cache file: %s", cache->filepath);
+		c2c_benchmark_cache_close(cache);
+		return -1;
+	}
+	if (!exists || mismatch) {
+		fprintf(cache->fp, "# fingerprint: %s\n", fingerprint);
+		fprintf(cache->fp, "# params: %s\n", params);
+		fflush(cache->fp);
+	}
+
+	return 0;
+}
+
+void c2c_benchmark_cache_close(c2c_benchmark_cache_t *cache)
+{
+	if (cache->fp) {
+		fclose(cache->fp);
+		cache->fp = NULL;
+	}
+	if (cache->vals) {
+		free(cache->vals);
+		cache->vals = NULL;
+	}
+	if (cache->ts) {
+		free(cache->ts);
+		cache->ts = NULL;
+	}
+}
+
+int c2c_benchmark_cache_get(c2c_benchmark_cache_t *cache, int32_t i,
+							int32_t j, int64_t *vals)
+{
+	if (i < 0 || j < 0 || i >= cache->num_cores || j >= cache->num_cores) {
+		return -1;
+	}
+
+	size_t idx = (size_t)cache->num_cores * i + j;
+	int64_t ts = cache->ts[idx];
+	if (ts == 0) {
+		return -1;
+	}
+	if (cache->expire_sec > 0 &&
+		(int64_t)time(NULL) - ts > cache->expire_sec) {
+		return -1;
+	}
+
+	memcpy(vals, cache->vals + idx * cache->n_val,
+		   sizeof(int64_t) * cache->n_val);
+	return 0;
+}
+
+void c2c_benchmark_cache_put(c2c_benchmark_cache_t *cache, int32_t i,
+							 int32_t j, const int64_t *vals)
+{
+	if (i < 0 || j < 0 || i >= cache->num_cores || j >= cache->num_cores) {
+		return;
+	}
+
+	int64_t ts = (int64_t)time(NULL);
+	size_t idx = (size_t)cache->num_cores * i + j;
+	memcpy(cache->vals + idx * cache->n_val, vals,
+		   sizeof(int64_t) * cache->n_val);
+	cache->ts[idx] = ts;
+
+	if (cache->fp == NULL) {
+		return;
+	}
+
+	// flush every pair, so an interrupted sweep keeps what it measured
+	fprintf(cache->fp, "%d,%d,%lld", i, j, (long long)ts);
+	for (int32_t k = 0; k < cache->n_val; ++k) {
+		fprintf(cache->fp, ",%lld", (long long)vals[k]);
+	}
+	fprintf(cache->fp, "\n");
+	fflush(cache->fp);
+}
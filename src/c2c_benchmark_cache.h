@@ -0,0 +1,112 @@
+/******************************************************************************
+ *  @file         c2c_benchmark_cache.h
+ *  @author       Muggle Wei
+ *  @email        mugglewei@gmail.com
+ *  @date         2025-08-02
+ *  @copyright    Copyright 2025 Muggle Wei
+ *  @license      MIT License
+ *  @brief        c2c benchmark resumable core matrix cache
+ *****************************************************************************/
+
+#ifndef C2C_BENCHMARK_CACHE_H_
+#define C2C_BENCHMARK_CACHE_H_
+
+#include "c2c_benchmark.h"
+
+EXTERN_C_BEGIN
+
+#define C2C_BENCHMARK_CACHE_MAX_VAL 8
+
+#define C2C_BENCHMARK_CACHE_USAGE                              \
+	"  -C\n"                                                   \
+	"    cache matrix pairs, resume sweep from cached pairs\n" \
+	"  -E int\n"                                               \
+	"    cached pair expire seconds, 0 means never expire\n"   \
+	"  -X\n"                                                   \
+	"    rebuild matrix from cache only, without run\n"
+
+/**
+ * @brief cache of core pair results
+ *
+ * each (i, j) pair, i < j, holds n_val values; pairs are appended to
+ * ./c2c_benchmark_reports/cache_<name>_<hash>.csv as soon as measured,
+ * where hash is hash of machine fingerprint and run parameters
+ */
+typedef struct {
+	char filepath[MUGGLE_MAX_PATH];
+	FILE *fp;
+	int32_t num_cores;
+	int32_t n_val;
+	int64_t expire_sec;
+	int64_t *vals; //!< num_cores * num_cores * n_val
+	int64_t *ts; //!< num_cores * num_cores, 0 means missing
+} c2c_benchmark_cache_t;
+
+/**
+ * @brief machine fingerprint, CPU model, microcode, kernel and topology
+ *
+ * @param buf   output buffer
+ * @param size  size of output buffer
+ *
+ * @return buf
+ */
+const char *c2c_benchmark_cache_fingerprint(char *buf, size_t size);
+
+/**
+ * @brief open cache and load pairs already measured
+ *
+ * a cache file whose fingerprint or parameters don't match is rewritten
+ *
+ * @param cache       cache
+ * @param name        benchmark name
+ * @param params      run parameters that affect result
+ * @param num_cores   number of cores
+ * @param n_val       number of values per pair
+ * @param expire_sec  cached pairs older than it are stale, 0 never expire
+ * @param readonly    only load, never write cache file
+ *
+ * @return
+ *     0 - success
+ *     otherwise - failed
+ */
+int c2c_benchmark_cache_open(c2c_benchmark_cache_t *cache, const char *name,
+							 const char *params, int32_t num_cores,
+							 int32_t n_val, int64_t expire_sec,
+							 int32_t readonly);
+
+/**
+ * @brief close cache
+ *
+ * @param cache  cache
+ */
+void c2c_benchmark_cache_close(c2c_benchmark_cache_t *cache);
+
+/**
+ * @brief get values of pair
+ *
+ * @param cache  cache
+ * @param i      producer core
+ * @param j      consumer core
+ * @param vals   output values, n_val elements
+ *
+ * @return
+ *     0 - hit
+ *     otherwise - missing or stale
+ */
+int c2c_benchmark_cache_get(c2c_benchmark_cache_t *cache, int32_t i,
+							int32_t j, int64_t *vals);
+
+/**
+ * @brief put values of pair and append it into cache file
+ *
+ * @param cache  cache
+ * @param i      producer core
+ * @param j      consumer core
+ * @param vals   values, n_val elements
+ */
+void c2c_benchmark_cache_put(c2c_benchmark_cache_t *cache, int32_t i,
+							 int32_t j, const int64_t *vals);
+
+EXTERN_C_END
+
+#endif // !C2C_BENCHMARK_CACHE_H_
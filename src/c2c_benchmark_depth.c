@@ -0,0 +1,187 @@
+#include "c2c_benchmark_depth.h"
+
+typedef struct {
+	int64_t end_ns;
+	int64_t elapsed;
+} depth_msg_t;
+
+static int compare_int64(const void *a, const void *b)
+{
+	const int64_t arg1 = *(const int64_t *)a;
+	const int64_t arg2 = *(const int64_t *)b;
+
+	if (arg1 < arg2)
+		return -1;
+	if (arg1 > arg2)
+		return 1;
+	return 0;
+}
+
+static int compare_int32(const void *a, const void *b)
+{
+	const int32_t arg1 = *(const int32_t *)a;
+	const int32_t arg2 = *(const int32_t *)b;
+
+	if (arg1 < arg2)
+		return -1;
+	if (arg1 > arg2)
+		return 1;
+	return 0;
+}
+
+static int compare_msg(const void *a, const void *b)
+{
+	return compare_int64(&((const depth_msg_t *)a)->end_ns,
+						 &((const depth_msg_t *)b)->end_ns);
+}
+
+static int64_t depth_ts_ns(const struct timespec *ts)
+{
+	return (int64_t)ts->tv_sec * 1000000000 + (int64_t)ts->tv_nsec;
+}
+
+static int depth_bucket(int32_t depth)
+{
+	int b = 0;
+	while (depth > 1 && b < C2C_BENCHMARK_DEPTH_N_BUCKET - 1) {
+		depth >>= 1;
+		++b;
+	}
+	return b;
+}
+
+int c2c_benchmark_depth_compute(const cache_line_data_t *datas,
+								size_t total_cnt, c2c_benchmark_depth_t *depth)
+{
+	memset(depth, 0, sizeof(*depth));
+	for (int b = 0; b < C2C_BENCHMARK_DEPTH_N_BUCKET; ++b) {
+		depth->lat_p50[b] = -1;
+		depth->lat_p99[b] = -1;
+	}
+	if (total_cnt == 0) {
+		return 0;
+	}
+
+	int64_t *starts = (int64_t *)malloc(sizeof(int64_t) * total_cnt);
+	depth_msg_t *msgs = (depth_msg_t *)malloc(sizeof(depth_msg_t) * total_cnt);
+	int32_t *depths = (int32_t *)malloc(sizeof(int32_t) * total_cnt);
+	int64_t *lats = (int64_t *)malloc(sizeof(int64_t) * total_cnt);
+	if (starts == NULL || msgs == NULL || depths == NULL || lats == NULL) {
+		free(starts);
+		free(msgs);
+		free(depths);
+		free(lats);
+		return -1;
+	}
+
+	for (size_t i = 0; i < total_cnt; ++i) {
+		const muggle_time_counter_t *tc = &datas[i].tc;
+		starts[i] = depth_ts_ns(&tc->start_ts);
+		msgs[i].end_ns = depth_ts_ns(&tc->end_ts);
+		msgs[i].elapsed = msgs[i].end_ns - starts[i];
+	}
+	qsort(starts, total_cnt, sizeof(int64_t), compare_int64);
+	qsort(msgs, total_cnt, sizeof(depth_msg_t), compare_msg);
+
+	// ends are sorted, so the number of started messages only grows
+	size_t n_started = 0;
+	for (size_t k = 0; k < total_cnt; ++k) {
+		while (n_started < total_cnt && starts[n_started] <= msgs[k].end_ns) {
+			++n_started;
+		}
+		// clock skew between cores may push it below the message itself
+		int64_t d = (int64_t)n_started - (int64_t)k;
+		depths[k] = d < 1 ? 1 : (int32_t)d;
+		depth->counts[depth_bucket(depths[k])]++;
+	}
+
+	// latency of each bucket, group messages by bucket then sort each group
+	size_t offsets[C2C_BENCHMARK_DEPTH_N_BUCKET];
+	size_t offset = 0;
+	for (int b = 0; b < C2C_BENCHMARK_DEPTH_N_BUCKET; ++b) {
+		offsets[b] = offset;
+		offset += depth->counts[b];
+	}
+	for (size_t k = 0; k < total_cnt; ++k) {
+		lats[offsets[depth_bucket(depths[k])]++] = msgs[k].elapsed;
+	}
+	offset = 0;
+	for (int b = 0; b < C2C_BENCHMARK_DEPTH_N_BUCKET; ++b) {
+		size_t n = (size_t)depth->counts[b];
+		if (n > 0) {
+			int64_t *arr = lats + offset;
+			qsort(arr, n, sizeof(int64_t), compare_int64);
+			depth->lat_p50[b] = arr[n / 2];
+			depth->lat_p99[b] = arr[n * 99 / 100];
+		}
+		offset += n;
+	}
+
+	qsort(depths, total_cnt, sizeof(int32_t), compare_int32);
+	depth->p50 = depths[total_cnt / 2];
+	depth->p99 = depths[total_cnt * 99 / 100];
+	depth->max = depths[total_cnt - 1];
+
+	free(lats);
+	free(depths);
+	free(msgs);
+	free(starts);
+
+	return 0;
+}
+
+static void depth_bucket_name(int b, char *buf, size_t size)
+{
+	int32_t lo = (int32_t)1 << b;
+	if (b == C2C_BENCHMARK_DEPTH_N_BUCKET - 1) {
+		snprintf(buf, size, "%d+", lo);
+	} else if (b == 0) {
+		snprintf(buf, size, "%d", lo);
+	} else {
+		snprintf(buf, size, "%d-%d", lo, lo * 2 - 1);
+	}
+}
+
+void c2c_benchmark_depth_report(const char *name, const char *producer_cores,
+								const char *consumer_cores,
+								const c2c_benchmark_depth_t *depth)
+{
+	char filepath[MUGGLE_MAX_PATH];
+	snprintf(filepath, sizeof(filepath),
+			 "./c2c_benchmark_reports/depth_%s_c%s_to_c%s.csv", name,
+			 producer_cores, consumer_cores);
+	FILE *fp = muggle_os_fopen(filepath, "w");
+	if (fp == NULL) {
+		LOG_ERROR("failed open depth report: %s", filepath);
+		return;
+	}
+
+	fprintf(fp, "depth,count,p50,p99\n");
+	for (int b = 0; b < C2C_BENCHMARK_DEPTH_N_BUCKET; ++b) {
+		char bucket[32];
+		depth_bucket_name(b, bucket, sizeof(bucket));
+		fprintf(fp, "%s,%llu,%lld,%lld\n", bucket,
+				(unsigned long long)depth->counts[b],
+				(long long)depth->lat_p50[b], (long long)depth->lat_p99[b]);
+	}
+	fclose(fp);
+	LOG_INFO("generate depth report: %s", filepath);
+}
+
+void c2c_benchmark_depth_print(FILE *fp, const c2c_benchmark_depth_t *depth)
+{
+	fprintf(fp, "%10s%12s%12s%12s\n", "depth", "count", "p50(ns)",
+			"p99(ns)");
+	for (int b = 0; b < C2C_BENCHMARK_DEPTH_N_BUCKET; ++b) {
+		if (depth->counts[b] == 0) {
+			continue;
+		}
+		char bucket[32];
+		depth_bucket_name(b, bucket, sizeof(bucket));
+		fprintf(fp, "%10s%12llu%12lld%12lld\n", bucket,
+				(unsigned long long)depth->counts[b],
+				(long long)depth->lat_p50[b], (long long)depth->lat_p99[b]);
+	}
+	fprintf(fp, "depth p50/p99/max: %d/%d/%d\n", depth->p50, depth->p99,
+			depth->max);
+}
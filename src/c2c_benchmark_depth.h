@@ -0,0 +1,78 @@
+/******************************************************************************
+ *  @file         c2c_benchmark_depth.h
+ *  @author       Muggle Wei
+ *  @email        mugglewei@gmail.com
+ *  @date         2025-08-02
+ *  @copyright    Copyright 2025 Muggle Wei
+ *  @license      MIT License
+ *  @brief        c2c benchmark queue depth at dequeue
+ *****************************************************************************/
+
+#ifndef C2C_BENCHMARK_DEPTH_H_
+#define C2C_BENCHMARK_DEPTH_H_
+
+#include "c2c_benchmark.h"
+
+EXTERN_C_BEGIN
+
+/**
+ * @brief number of depth buckets, bucket b holds depth in [2^b, 2^(b+1)),
+ * the last bucket holds all deeper ones
+ */
+#define C2C_BENCHMARK_DEPTH_N_BUCKET 12
+
+/**
+ * @brief queue depth seen by each message when it is dequeued
+ *
+ * Depth is derived from timestamps after the run, so consumers need no
+ * extra work: sorted by end timestamp the k-th dequeued message sees
+ * (messages started no later than its end) - k messages in queue,
+ * itself included. Messages being written at that moment are counted.
+ */
+typedef struct {
+	int32_t p50; //!< depth percentiles
+	int32_t p99;
+	int32_t max;
+	uint64_t counts[C2C_BENCHMARK_DEPTH_N_BUCKET]; //!< messages per bucket
+	int64_t lat_p50[C2C_BENCHMARK_DEPTH_N_BUCKET]; //!< -1 if bucket empty
+	int64_t lat_p99[C2C_BENCHMARK_DEPTH_N_BUCKET];
+} c2c_benchmark_depth_t;
+
+/**
+ * @brief compute queue depth at dequeue and latency per depth bucket
+ *
+ * @param datas      time counter array, start is enqueue, end is dequeue
+ * @param total_cnt  total count
+ * @param depth      output depth statistics
+ *
+ * @return
+ *     0 - success
+ *     otherwise - failed
+ */
+int c2c_benchmark_depth_compute(const cache_line_data_t *datas,
+								size_t total_cnt, c2c_benchmark_depth_t *depth);
+
+/**
+ * @brief write depth buckets into
+ * ./c2c_benchmark_reports/depth_<name>_c<producer>_to_c<consumer>.csv
+ *
+ * @param name            benchmark name
+ * @param producer_cores  producer bind cores
+ * @param consumer_cores  consumer bind cores
+ * @param depth           depth statistics
+ */
+void c2c_benchmark_depth_report(const char *name, const char *producer_cores,
+								const char *consumer_cores,
+								const c2c_benchmark_depth_t *depth);
+
+/**
+ * @brief print latency of each non empty depth bucket
+ *
+ * @param fp     output file
+ * @param depth  depth statistics
+ */
+void c2c_benchmark_depth_print(FILE *fp, const c2c_benchmark_depth_t *depth);
+
+EXTERN_C_END
+
+#endif // !C2C_BENCHMARK_DEPTH_H_
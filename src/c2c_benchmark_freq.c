@@ -0,0 +1,143 @@
+#include "c2c_benchmark_freq.h"
+#if MUGGLE_PLATFORM_LINUX
+	#include <fcntl.h>
+#endif
+
+#define FREQ_MSR_APERF 0xE8
+#define FREQ_LOOP_US 2000
+
+#if defined(__GNUC__) || defined(__clang__)
+	// keep x in register and make every add depend on the previous one;
+	// add register instead of immediate, some cores fold immediate add
+	// chains at rename and run them faster than one per cycle
+	#define FREQ_DEP_ADD(x, y) \
+		x += y;                \
+		__asm__ volatile("" : "+r"(x))
+#else
+	#define FREQ_DEP_ADD(x, y) x += y
+#endif
+
+int64_t c2c_benchmark_freq_loop_mhz(int32_t us)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	uint64_t x = 0;
+	uint64_t y = 1;
+	__asm__ volatile("" : "+r"(y));
+#else
+	volatile uint64_t x = 0;
+	uint64_t y = 1;
+#endif
+	uint64_t n_add = 0;
+
+	muggle_time_counter_t tc;
+	muggle_time_counter_init(&tc);
+	muggle_time_counter_start(&tc);
+	int64_t elapsed = 0;
+	do {
+		for (int i = 0; i < 1024; ++i) {
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+			FREQ_DEP_ADD(x, y);
+		}
+		n_add += 1024 * 16;
+		muggle_time_counter_end(&tc);
+		elapsed = muggle_time_counter_interval_ns(&tc);
+	} while (elapsed < (int64_t)us * 1000);
+	(void)x;
+
+	return (int64_t)(n_add * 1000 / (uint64_t)elapsed);
+}
+
+#if MUGGLE_PLATFORM_LINUX
+static int freq_read_msr(int fd, uint32_t reg, uint64_t *val)
+{
+	return pread(fd, val, sizeof(*val), reg) == sizeof(*val) ? 0 : -1;
+}
+#endif
+
+void c2c_benchmark_freq_begin(c2c_benchmark_freq_t *freq, int32_t core)
+{
+	memset(freq, 0, sizeof(*freq));
+	freq->core = core;
+	freq->method = C2C_BENCHMARK_FREQ_LOOP;
+	freq->msr_fd = -1;
+
+#if MUGGLE_PLATFORM_LINUX
+	char filepath[64];
+	snprintf(filepath, sizeof(filepath), "/dev/cpu/%d/msr", core);
+	freq->msr_fd = open(filepath, O_RDONLY);
+	if (freq->msr_fd != -1) {
+		if (freq_read_msr(freq->msr_fd, FREQ_MSR_APERF, &freq->aperf) == 0) {
+			freq->method = C2C_BENCHMARK_FREQ_APERF;
+			muggle_time_counter_init(&freq->tc);
+			muggle_time_counter_start(&freq->tc);
+			return;
+		}
+		close(freq->msr_fd);
+		freq->msr_fd = -1;
+	}
+#endif
+
+	freq->loop_mhz = c2c_benchmark_freq_loop_mhz(FREQ_LOOP_US);
+}
+
+int64_t c2c_benchmark_freq_end(c2c_benchmark_freq_t *freq)
+{
+	int64_t mhz = 0;
+
+#if MUGGLE_PLATFORM_LINUX
+	if (freq->method == C2C_BENCHMARK_FREQ_APERF) {
+		uint64_t aperf = 0;
+		muggle_time_counter_end(&freq->tc);
+		if (freq_read_msr(freq->msr_fd, FREQ_MSR_APERF, &aperf) == 0) {
+			int64_t elapsed = muggle_time_counter_interval_ns(&freq->tc);
+			if (elapsed > 0) {
+				mhz = (int64_t)((aperf - freq->aperf) * 1000 / elapsed);
+			}
+		}
+		close(freq->msr_fd);
+		freq->msr_fd = -1;
+		return mhz;
+	}
+#endif
+
+	mhz = (freq->loop_mhz + c2c_benchmark_freq_loop_mhz(FREQ_LOOP_US)) / 2;
+	return mhz;
+}
+
+int64_t c2c_benchmark_ns_to_cycles(int64_t ns, int64_t mhz)
+{
+	return ns * mhz / 1000;
+}
+
+void c2c_benchmark_print_freq(FILE *fp, const int64_t *min_mhz,
+							  const int64_t *max_mhz, int32_t num_cores)
+{
+	fprintf(fp, "%6s%10s%10s\n", "core", "min(MHz)", "max(MHz)");
+	for (int32_t i = 0; i < num_cores; ++i) {
+		if (min_mhz[i] == 0) {
+			continue;
+		}
+		int drift = (max_mhz[i] - min_mhz[i]) * 20 > max_mhz[i];
+		fprintf(fp, "%6d%10lld%10lld%s\n", i, (long long)min_mhz[i],
+				(long long)max_mhz[i], drift ? " [drift]" : "");
+		if (drift) {
+			LOG_WARNING("core %d frequency drift during sweep: %lld - %lld "
+						"MHz",
+						i, (long long)min_mhz[i], (long long)max_mhz[i]);
+		}
+	}
+}
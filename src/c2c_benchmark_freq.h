@@ -0,0 +1,88 @@
+/******************************************************************************
+ *  @file         c2c_benchmark_freq.h
+ *  @author       Muggle Wei
+ *  @email        mugglewei@gmail.com
+ *  @date         2025-08-02
+ *  @copyright    Copyright 2025 Muggle Wei
+ *  @license      MIT License
+ *  @brief        c2c benchmark effective core frequency
+ *****************************************************************************/
+
+#ifndef C2C_BENCHMARK_FREQ_H_
+#define C2C_BENCHMARK_FREQ_H_
+
+#include "c2c_benchmark.h"
+
+EXTERN_C_BEGIN
+
+#define C2C_BENCHMARK_FREQ_LOOP 0 //!< calibrated dependent add loop
+#define C2C_BENCHMARK_FREQ_APERF 1 //!< APERF MSR
+
+/**
+ * @brief effective frequency of a core over a measured interval
+ *
+ * Use APERF from /dev/cpu/<core>/msr when readable, APERF only counts in
+ * C0, so the thread is expected to be busy in the interval. Otherwise run
+ * a short dependent add loop at begin and end, one add per cycle, and
+ * average them.
+ */
+typedef struct {
+	int32_t core;
+	int32_t method;
+	int msr_fd;
+	uint64_t aperf;
+	muggle_time_counter_t tc;
+	int64_t loop_mhz;
+} c2c_benchmark_freq_t;
+
+/**
+ * @brief begin frequency measurement, call in thread bound to core
+ *
+ * @param freq  frequency measurement
+ * @param core  bound core
+ */
+void c2c_benchmark_freq_begin(c2c_benchmark_freq_t *freq, int32_t core);
+
+/**
+ * @brief end frequency measurement, call in the same thread as begin
+ *
+ * @param freq  frequency measurement
+ *
+ * @return effective frequency in MHz, 0 if failed
+ */
+int64_t c2c_benchmark_freq_end(c2c_benchmark_freq_t *freq);
+
+/**
+ * @brief effective frequency of current core with dependent add loop
+ *
+ * @param us  loop duration in microseconds
+ *
+ * @return effective frequency in MHz
+ */
+int64_t c2c_benchmark_freq_loop_mhz(int32_t us);
+
+/**
+ * @brief convert nanoseconds into cycles
+ *
+ * @param ns   nanoseconds
+ * @param mhz  frequency in MHz
+ *
+ * @return cycles
+ */
+int64_t c2c_benchmark_ns_to_cycles(int64_t ns, int64_t mhz);
+
+/**
+ * @brief print min/max effective frequency of each core observed in a
+ * matrix sweep, and warn cores whose frequency drifts more than 5%
+ *
+ * @param fp         output file
+ * @param min_mhz    min frequency of each core, 0 means not measured
+ * @param max_mhz    max frequency of each core
+ * @param num_cores  number of cores
+ */
+void c2c_benchmark_print_freq(FILE *fp, const int64_t *min_mhz,
+							  const int64_t *max_mhz, int32_t num_cores);
+
+EXTERN_C_END
+
+#endif // !C2C_BENCHMARK_FREQ_H_
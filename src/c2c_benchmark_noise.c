@@ -0,0 +1,513 @@
+#include "c2c_benchmark_noise.h"
+#include "c2c_benchmark_preflight.h"
+
+#define NOISE_PROFILE_STREAM 0
+#define NOISE_PROFILE_L3 1
+#define NOISE_PROFILE_PINGPONG 2
+#define NOISE_PROFILE_ATOMIC 3
+
+typedef union {
+	MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+	muggle_atomic_int v;
+} noise_line_t;
+
+typedef struct {
+	c2c_benchmark_noise_t *noise;
+	int32_t profile;
+	int32_t core;
+	int32_t role;
+	size_t n_bytes;
+	noise_line_t *lines;
+} noise_thread_args_t;
+
+struct c2c_benchmark_noise {
+	muggle_atomic_int running;
+	muggle_atomic_int n_ready;
+	muggle_atomic_int n_failed;
+	int32_t n_thread;
+	muggle_thread_t threads[C2C_BENCHMARK_NOISE_MAX_THREAD];
+	noise_thread_args_t th_args[C2C_BENCHMARK_NOISE_MAX_THREAD];
+	int32_t n_line_buf;
+	noise_line_t *line_bufs[C2C_BENCHMARK_NOISE_MAX_SPEC];
+};
+
+static int noise_is_running(c2c_benchmark_noise_t *noise)
+{
+	return muggle_atomic_load(&noise->running, muggle_memory_order_relaxed);
+}
+
+/**
+ * @brief report that noise thread finished setup and is about to make
+ * noise, or failed setup and makes none
+ */
+static void noise_ready(c2c_benchmark_noise_t *noise, int ok)
+{
+	if (!ok) {
+		muggle_atomic_fetch_add(&noise->n_failed, 1,
+								muggle_memory_order_relaxed);
+	}
+	muggle_atomic_fetch_add(&noise->n_ready, 1, muggle_memory_order_release);
+}
+
+static void noise_stream(noise_thread_args_t *th_args)
+{
+	c2c_benchmark_noise_t *noise = th_args->noise;
+	size_t half = th_args->n_bytes / 2;
+	char *buf = (char *)malloc(half * 2);
+	if (buf == NULL) {
+		LOG_ERROR("noise stream failed allocate %llu bytes",
+				  (unsigned long long)th_args->n_bytes);
+		noise_ready(noise, 0);
+		return;
+	}
+	memset(buf, 1, half * 2);
+	noise_ready(noise, 1);
+
+	while (noise_is_running(noise)) {
+		memcpy(buf + half, buf, half);
+		memcpy(buf, buf + half, half);
+	}
+
+	free(buf);
+}
+
+static void noise_l3(noise_thread_args_t *th_args)
+{
+	c2c_benchmark_noise_t *noise = th_args->noise;
+	size_t n_lines = th_args->n_bytes / 64;
+	if (n_lines == 0) {
+		n_lines = 1;
+	}
+	volatile char *buf = (volatile char *)malloc(n_lines * 64);
+	if (buf == NULL) {
+		LOG_ERROR("noise l3 failed allocate %llu bytes",
+				  (unsigned long long)th_args->n_bytes);
+		noise_ready(noise, 0);
+		return;
+	}
+	memset((void *)buf, 0, n_lines * 64);
+	noise_ready(noise, 1);
+
+	// large prime stride defeats the hardware prefetchers
+	size_t idx = 0;
+	while (noise_is_running(noise)) {
+		for (int i = 0; i < 4096; ++i) {
+			idx = (idx + 4099) % n_lines;
+			buf[idx * 64] += 1;
+		}
+	}
+
+	free((void *)buf);
+}
+
+static void noise_pingpong(noise_thread_args_t *th_args)
+{
+	c2c_benchmark_noise_t *noise = th_args->noise;
+	muggle_atomic_int *ping = &th_args->lines[0].v;
+	muggle_atomic_int *pong = &th_args->lines[1].v;
+	noise_ready(noise, 1);
+
+	for (int32_t i = 0;; i = (i + 1) & 0x3fffffff) {
+		if (th_args->role == 0) {
+			muggle_atomic_store(ping, i, muggle_memory_order_release);
+			while (muggle_atomic_load(pong, muggle_memory_order_acquire) !=
+				   i) {
+				if (!noise_is_running(noise)) {
+					return;
+				}
+			}
+		} else {
+			while (muggle_atomic_load(ping, muggle_memory_order_acquire) !=
+				   i) {
+				if (!noise_is_running(noise)) {
+					return;
+				}
+			}
+			muggle_atomic_store(pong, i, muggle_memory_order_release);
+		}
+	}
+}
+
+static void noise_atomic(noise_thread_args_t *th_args)
+{
+	c2c_benchmark_noise_t *noise = th_args->noise;
+	muggle_atomic_int *v = &th_args->lines[0].v;
+	noise_ready(noise, 1);
+	while (noise_is_running(noise)) {
+		for (int i = 0; i < 1024; ++i) {
+			muggle_atomic_fetch_add(v, 1, muggle_memory_order_relaxed);
+		}
+	}
+}
+
+static muggle_thread_ret_t proc_noise(void *p)
+{
+	noise_thread_args_t *th_args = (noise_thread_args_t *)p;
+	c2c_benchmark_noise_t *noise = th_args->noise;
+
+	// noise never runs under SCHED_FIFO, a FIFO busy loop could starve
+	// anything else on its core
+	int ret = c2c_benchmark_set_affinity(th_args->core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed noise bind CPU core #%d, err=%s", th_args->core,
+				  errmsg);
+		noise_ready(noise, 0);
+		return 0;
+	}
+	ret = c2c_benchmark_reset_sched();
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed reset noise scheduling policy, err=%s", errmsg);
+	}
+
+	// every profile signals ready itself, after its setup
+	switch (th_args->profile) {
+	case NOISE_PROFILE_STREAM: {
+		noise_stream(th_args);
+	} break;
+	case NOISE_PROFILE_L3: {
+		noise_l3(th_args);
+	} break;
+	case NOISE_PROFILE_PINGPONG: {
+		noise_pingpong(th_args);
+	} break;
+	case NOISE_PROFILE_ATOMIC: {
+		noise_atomic(th_args);
+	} break;
+	}
+
+	return 0;
+}
+
+static size_t parse_bytes(const char *s)
+{
+	char *end = NULL;
+	size_t n = (size_t)strtoull(s, &end, 10);
+	if (end) {
+		switch (*end) {
+		case 'k':
+		case 'K': {
+			n *= 1024;
+		} break;
+		case 'm':
+		case 'M': {
+			n *= 1024 * 1024;
+		} break;
+		case 'g':
+		case 'G': {
+			n *= 1024 * 1024 * 1024;
+		} break;
+		}
+	}
+	return n;
+}
+
+static int32_t parse_cores(char *s, const int32_t *measured_cores,
+						   int32_t n_measured, int32_t *cores, int32_t max_n)
+{
+	int32_t n = 0;
+	char *token = s;
+	while (token && *token && n < max_n) {
+		char *next = strchr(token, ',');
+		if (next) {
+			*next++ = '\0';
+		}
+
+		if (strcmp(token, "sib") == 0) {
+			for (int32_t i = 0; i < n_measured; ++i) {
+				n += c2c_benchmark_smt_siblings(measured_cores[i], cores + n,
+												max_n - n);
+			}
+		} else {
+			cores[n++] = atoi(token);
+		}
+
+		token = next;
+	}
+	return n;
+}
+
+void c2c_benchmark_noise_add_spec(c2c_benchmark_noise_args_t *noise_args,
+								  char *spec)
+{
+	if (noise_args->n_spec >= C2C_BENCHMARK_NOISE_MAX_SPEC) {
+		LOG_ERROR("too many noise spec, ignore: %s", spec);
+		return;
+	}
+	noise_args->specs[noise_args->n_spec++] = spec;
+}
+
+c2c_benchmark_noise_t *
+c2c_benchmark_noise_start(c2c_benchmark_noise_args_t *noise_args,
+						  const int32_t *measured_cores, int32_t n_measured)
+{
+	if (noise_args->n_spec == 0) {
+		return NULL;
+	}
+
+	c2c_benchmark_noise_t *noise =
+		(c2c_benchmark_noise_t *)malloc(sizeof(c2c_benchmark_noise_t));
+	if (noise == NULL) {
+		LOG_ERROR("failed allocate noise");
+		return NULL;
+	}
+	memset(noise, 0, sizeof(*noise));
+	noise->running = 1;
+
+	for (int32_t s = 0; s < noise_args->n_spec; ++s) {
+		// split spec into profile, cores and bytes; spec is not modified
+		char buf[256];
+		strncpy(buf, noise_args->specs[s], sizeof(buf) - 1);
+		buf[sizeof(buf) - 1] = '\0';
+
+		char *s_profile = buf;
+		char *s_cores = strchr(s_profile, ':');
+		if (s_cores == NULL) {
+			LOG_ERROR("invalid noise spec: %s", noise_args->specs[s]);
+			continue;
+		}
+		*s_cores++ = '\0';
+		char *s_bytes = strchr(s_cores, ':');
+		if (s_bytes) {
+			*s_bytes++ = '\0';
+		}
+
+		int32_t profile = -1;
+		size_t n_bytes = 0;
+		if (strcmp(s_profile, "stream") == 0) {
+			profile = NOISE_PROFILE_STREAM;
+			n_bytes = 256 * 1024 * 1024;
+		} else if (strcmp(s_profile, "l3") == 0) {
+			profile = NOISE_PROFILE_L3;
+			n_bytes = 32 * 1024 * 1024;
+		} else if (strcmp(s_profile, "pingpong") == 0) {
+			profile = NOISE_PROFILE_PINGPONG;
+		} else if (strcmp(s_profile, "atomic") == 0) {
+			profile = NOISE_PROFILE_ATOMIC;
+		} else {
+			LOG_ERROR("invalid noise profile: %s", s_profile);
+			continue;
+		}
+		if (s_bytes) {
+			n_bytes = parse_bytes(s_bytes);
+		}
+
+		int32_t cores[C2C_BENCHMARK_NOISE_MAX_THREAD];
+		int32_t n_parsed =
+			parse_cores(s_cores, measured_cores, n_measured, cores,
+						C2C_BENCHMARK_NOISE_MAX_THREAD - noise->n_thread);
+
+		// a noise thread on a measured core would share it with the
+		// measured thread, so drop measured cores from the spec
+		int32_t n_cores = 0;
+		for (int32_t i = 0; i < n_parsed; ++i) {
+			int is_measured = 0;
+			for (int32_t m = 0; m < n_measured; ++m) {
+				if (cores[i] == measured_cores[m]) {
+					is_measured = 1;
+					break;
+				}
+			}
+			if (is_measured) {
+				LOG_WARNING("skip noise %s on core #%d, it is measured core",
+							s_profile, cores[i]);
+				continue;
+			}
+			cores[n_cores++] = cores[i];
+		}
+
+		if (profile == NOISE_PROFILE_PINGPONG && n_cores % 2 != 0) {
+			LOG_WARNING("noise pingpong need core pairs, ignore core %d",
+						cores[n_cores - 1]);
+			--n_cores;
+		}
+		if (n_cores == 0) {
+			LOG_WARNING("skip noise spec %s, no core left",
+						noise_args->specs[s]);
+			continue;
+		}
+
+		noise_line_t *lines =
+			(noise_line_t *)malloc(sizeof(noise_line_t) * (n_cores + 1));
+		if (lines == NULL) {
+			LOG_ERROR("failed allocate noise lines");
+			continue;
+		}
+		memset(lines, 0, sizeof(noise_line_t) * (n_cores + 1));
+		for (int32_t i = 0; i < n_cores + 1; ++i) {
+			lines[i].v = -1;
+		}
+		noise->line_bufs[noise->n_line_buf++] = lines;
+
+		for (int32_t i = 0; i < n_cores; ++i) {
+			noise_thread_args_t *th_args = &noise->th_args[noise->n_thread];
+			th_args->noise = noise;
+			th_args->profile = profile;
+			th_args->core = cores[i];
+			th_args->role = i % 2;
+			th_args->n_bytes = n_bytes;
+			if (profile == NOISE_PROFILE_PINGPONG) {
+				th_args->lines = lines + (i / 2) * 2;
+			} else {
+				th_args->lines = lines;
+			}
+
+			LOG_INFO("start noise %s on core #%d", s_profile, cores[i]);
+			muggle_thread_create(&noise->threads[noise->n_thread],
+								 proc_noise, th_args);
+			noise->n_thread++;
+		}
+	}
+
+	if (noise->n_thread == 0) {
+		LOG_WARNING("no noise thread started, skip noise run");
+		for (int32_t i = 0; i < noise->n_line_buf; ++i) {
+			free(noise->line_bufs[i]);
+		}
+		free(noise);
+		return NULL;
+	}
+
+	// wait noise threads bind core and set up their buffers, then give
+	// them time to fill caches
+	while (muggle_atomic_load(&noise->n_ready, muggle_memory_order_acquire) !=
+		   noise->n_thread)
+		;
+	int32_t n_failed =
+		muggle_atomic_load(&noise->n_failed, muggle_memory_order_relaxed);
+	if (n_failed > 0) {
+		// part of the noise is missing, a run under it is not noisy run
+		LOG_WARNING("%d of %d noise threads failed setup, skip noise run",
+					n_failed, noise->n_thread);
+		c2c_benchmark_noise_stop(noise);
+		return NULL;
+	}
+	muggle_msleep(100);
+
+	return noise;
+}
+
+void c2c_benchmark_noise_stop(c2c_benchmark_noise_t *noise)
+{
+	if (noise == NULL) {
+		return;
+	}
+
+	muggle_atomic_store(&noise->running, 0, muggle_memory_order_relaxed);
+	for (int32_t i = 0; i < noise->n_thread; ++i) {
+		muggle_thread_join(&noise->threads[i]);
+	}
+	for (int32_t i = 0; i < noise->n_line_buf; ++i) {
+		free(noise->line_bufs[i]);
+	}
+	free(noise);
+	LOG_INFO("noise stopped");
+}
+
+int c2c_benchmark_noise_run(c2c_benchmark_noise_args_t *noise_args,
+							const int32_t *measured_cores, int32_t n_measured,
+							c2c_benchmark_noise_run_fn fn, void *ctx)
+{
+	fn(ctx, 0);
+	if (noise_args->n_spec == 0) {
+		return 0;
+	}
+
+	c2c_benchmark_noise_t *noise =
+		c2c_benchmark_noise_start(noise_args, measured_cores, n_measured);
+	if (noise == NULL) {
+		return 0;
+	}
+	fn(ctx, 1);
+	c2c_benchmark_noise_stop(noise);
+
+	return 1;
+}
+
+void c2c_benchmark_noise_print_head(FILE *fp, int noisy)
+{
+	if (noisy) {
+		fprintf(fp, "%12s%12s%12s%12s", "n_p50(ns)", "n_p99(ns)", "d_p50(ns)",
+				"d_p99(ns)");
+	}
+}
+
+void c2c_benchmark_noise_print_delta(FILE *fp, int noisy, int64_t quiet_p50,
+									 int64_t quiet_p99, int64_t noise_p50,
+									 int64_t noise_p99)
+{
+	if (!noisy) {
+		return;
+	}
+	if (quiet_p50 < 0 || noise_p50 < 0) {
+		fprintf(fp, "%12s%12s%12s%12s", "-", "-", "-", "-");
+		return;
+	}
+	fprintf(fp, "%12lld%12lld%12lld%12lld", (long long)noise_p50,
+			(long long)noise_p99, (long long)(noise_p50 - quiet_p50),
+			(long long)(noise_p99 - quiet_p99));
+}
+
+void c2c_benchmark_noise_csv_head(FILE *fp, int noisy)
+{
+	if (noisy) {
+		fprintf(fp, ",noise_p50,noise_p99,delta_p50,delta_p99");
+	}
+}
+
+void c2c_benchmark_noise_csv_delta(FILE *fp, int noisy, int64_t quiet_p50,
+								   int64_t quiet_p99, int64_t noise_p50,
+								   int64_t noise_p99)
+{
+	if (!noisy) {
+		return;
+	}
+	if (quiet_p50 < 0 || noise_p50 < 0) {
+		fprintf(fp, ",-1,-1,-1,-1");
+		return;
+	}
+	fprintf(fp, ",%lld,%lld,%lld,%lld", (long long)noise_p50,
+			(long long)noise_p99, (long long)(noise_p50 - quiet_p50),
+			(long long)(noise_p99 - quiet_p99));
+}
+
+int32_t c2c_benchmark_smt_siblings(int32_t core, int32_t *siblings,
+								   int32_t max_n)
+{
+#if MUGGLE_PLATFORM_WINDOWS
+	(void)core;
+	(void)siblings;
+	(void)max_n;
+	return 0;
+#else
+	char filepath[MUGGLE_MAX_PATH];
+	snprintf(filepath, sizeof(filepath),
+			 "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+			 core);
+	FILE *fp = fopen(filepath, "r");
+	if (fp == NULL) {
+		LOG_WARNING("failed open %s", filepath);
+		return 0;
+	}
+	char buf[256];
+	if (fgets(buf, sizeof(buf), fp) == NULL) {
+		buf[0] = '\0';
+	}
+	fclose(fp);
+
+	// format: "0,64" or "0-1"
+	int32_t all[C2C_BENCHMARK_NOISE_MAX_THREAD];
+	int32_t n_all = c2c_benchmark_parse_cpu_list(
+		buf, all, C2C_BENCHMARK_NOISE_MAX_THREAD);
+	int32_t n = 0;
+	for (int32_t i = 0; i < n_all && n < max_n; ++i) {
+		if (all[i] != core) {
+			siblings[n++] = all[i];
+		}
+	}
+	return n;
+#endif
+}
@@ -0,0 +1,147 @@
+/******************************************************************************
+ *  @file         c2c_benchmark_noise.h
+ *  @author       Muggle Wei
+ *  @email        mugglewei@gmail.com
+ *  @date         2025-08-02
+ *  @copyright    Copyright 2025 Muggle Wei
+ *  @license      MIT License
+ *  @brief        c2c benchmark background interference generator
+ *****************************************************************************/
+
+#ifndef C2C_BENCHMARK_NOISE_H_
+#define C2C_BENCHMARK_NOISE_H_
+
+#include "c2c_benchmark.h"
+
+EXTERN_C_BEGIN
+
+#define C2C_BENCHMARK_NOISE_MAX_SPEC 16
+#define C2C_BENCHMARK_NOISE_MAX_THREAD 64
+
+#define C2C_BENCHMARK_NOISE_USAGE                                         \
+	"  -N string\n"                                                       \
+	"    noise on other cores, <profile>:<cores>[:<bytes>], repeatable\n" \
+	"    profile: 'stream', 'l3', 'pingpong' or 'atomic'\n"                \
+	"    cores: split with comma, 'sib' means SMT siblings of measured\n"  \
+	"    cores; bytes: working set with K/M/G suffix\n"
+
+typedef struct {
+	int32_t n_spec;
+	char *specs[C2C_BENCHMARK_NOISE_MAX_SPEC];
+} c2c_benchmark_noise_args_t;
+
+typedef struct c2c_benchmark_noise c2c_benchmark_noise_t;
+
+/**
+ * @brief one measurement, run once quiet (noisy = 0), then once under
+ * noise (noisy = 1)
+ */
+typedef void (*c2c_benchmark_noise_run_fn)(void *ctx, int32_t noisy);
+
+/**
+ * @brief append noise spec from command line
+ *
+ * @param noise_args  noise arguments
+ * @param spec        noise spec, e.g. "stream:2,3:256M" or "l3:sib:8M"
+ */
+void c2c_benchmark_noise_add_spec(c2c_benchmark_noise_args_t *noise_args,
+								  char *spec);
+
+/**
+ * @brief start noise threads and wait until all of them running
+ *
+ * Measured cores are removed from the cores of every spec, and a spec
+ * without core left is skipped, both with a warning. Noise threads are
+ * ready once bound and their buffers are set up; if any of them fails,
+ * all of them are stopped and NULL is returned
+ *
+ * @param noise_args      noise arguments
+ * @param measured_cores  cores of measurement, for 'sib' expansion
+ * @param n_measured      number of measured cores
+ *
+ * @return
+ *     noise handle, NULL if failed, any noise thread failed setup or
+ *     no noise thread started
+ */
+c2c_benchmark_noise_t *
+c2c_benchmark_noise_start(c2c_benchmark_noise_args_t *noise_args,
+						  const int32_t *measured_cores, int32_t n_measured);
+
+/**
+ * @brief stop noise threads and free handle
+ *
+ * @param noise  noise handle
+ */
+void c2c_benchmark_noise_stop(c2c_benchmark_noise_t *noise);
+
+/**
+ * @brief run measurement quiet, then again under noise if noise spec
+ * exists and noise starts
+ *
+ * @param noise_args      noise arguments
+ * @param measured_cores  cores of measurement, noise never runs on them
+ * @param n_measured      number of measured cores
+ * @param fn              measurement
+ * @param ctx             user context of fn
+ *
+ * @return
+ *     1 - measurement ran under noise
+ *     0 - no noise spec, or noise skipped
+ */
+int c2c_benchmark_noise_run(c2c_benchmark_noise_args_t *noise_args,
+							const int32_t *measured_cores, int32_t n_measured,
+							c2c_benchmark_noise_run_fn fn, void *ctx);
+
+/**
+ * @brief print heads of noise p50/p99 and their delta against quiet run,
+ * print nothing if not noisy
+ *
+ * @param fp     output file
+ * @param noisy  measurement ran under noise
+ */
+void c2c_benchmark_noise_print_head(FILE *fp, int noisy);
+
+/**
+ * @brief print noise p50/p99 and their delta against quiet run, '-' if
+ * either run failed, print nothing if not noisy
+ *
+ * @param fp         output file
+ * @param noisy      measurement ran under noise
+ * @param quiet_p50  p50 of quiet run, negative if failed
+ * @param quiet_p99  p99 of quiet run
+ * @param noise_p50  p50 of noise run, negative if failed
+ * @param noise_p99  p99 of noise run
+ */
+void c2c_benchmark_noise_print_delta(FILE *fp, int noisy, int64_t quiet_p50,
+									 int64_t quiet_p99, int64_t noise_p50,
+									 int64_t noise_p99);
+
+/**
+ * @brief csv version of c2c_benchmark_noise_print_head, columns start with
+ * comma
+ */
+void c2c_benchmark_noise_csv_head(FILE *fp, int noisy);
+
+/**
+ * @brief csv version of c2c_benchmark_noise_print_delta, -1 if either run
+ * failed
+ */
+void c2c_benchmark_noise_csv_delta(FILE *fp, int noisy, int64_t quiet_p50,
+								   int64_t quiet_p99, int64_t noise_p50,
+								   int64_t noise_p99);
+
+/**
+ * @brief get SMT siblings of core, exclude core itself
+ *
+ * @param core      core number
+ * @param siblings  output siblings
+ * @param max_n     capacity of siblings
+ *
+ * @return number of siblings
+ */
+int32_t c2c_benchmark_smt_siblings(int32_t core, int32_t *siblings,
+								   int32_t max_n);
+
+EXTERN_C_END
+
+#endif // !C2C_BENCHMARK_NOISE_H_
@@ -0,0 +1,320 @@
+#include "c2c_benchmark_preflight.h"
+#if MUGGLE_PLATFORM_LINUX
+	#include <pthread.h>
+	#include <sched.h>
+	#include <dirent.h>
+	#include <sys/mman.h>
+#endif
+
+#define PREFLIGHT_MAX_CPU 4096
+
+static int32_t s_sched_fifo_priority = 0;
+static int32_t s_lock_memory = 0;
+
+void c2c_benchmark_set_sched_fifo(int32_t priority)
+{
+	s_sched_fifo_priority = priority;
+}
+
+void c2c_benchmark_set_lock_memory(int32_t enable)
+{
+	s_lock_memory = enable;
+}
+
+int32_t c2c_benchmark_get_sched_fifo(void)
+{
+	return s_sched_fifo_priority;
+}
+
+int32_t c2c_benchmark_get_lock_memory(void)
+{
+	return s_lock_memory;
+}
+
+int c2c_benchmark_apply_sched(void)
+{
+	if (s_sched_fifo_priority <= 0) {
+		return 0;
+	}
+
+#if MUGGLE_PLATFORM_LINUX
+	struct sched_param param;
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = s_sched_fifo_priority;
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#else
+	LOG_WARNING("SCHED_FIFO is not supported on this platform");
+	return 0;
+#endif
+}
+
+int c2c_benchmark_reset_sched(void)
+{
+#if MUGGLE_PLATFORM_LINUX
+	struct sched_param param;
+	memset(&param, 0, sizeof(param));
+	return pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+#else
+	return 0;
+#endif
+}
+
+#if MUGGLE_PLATFORM_LINUX
+
+/**
+ * @brief read first line of file, strip tailing newline
+ *
+ * @return 0 on success, -1 if file can't be read
+ */
+static int preflight_read_line(const char *filepath, char *buf, size_t size)
+{
+	buf[0] = '\0';
+	FILE *fp = fopen(filepath, "r");
+	if (fp == NULL) {
+		return -1;
+	}
+	if (fgets(buf, (int)size, fp) == NULL) {
+		buf[0] = '\0';
+	}
+	fclose(fp);
+
+	size_t len = strlen(buf);
+	while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r')) {
+		buf[--len] = '\0';
+	}
+	return 0;
+}
+
+static int preflight_cpu_in_list(const char *list, int32_t core)
+{
+	int32_t *cores = (int32_t *)malloc(sizeof(int32_t) * PREFLIGHT_MAX_CPU);
+	if (cores == NULL) {
+		return 0;
+	}
+	int32_t n = c2c_benchmark_parse_cpu_list(list, cores, PREFLIGHT_MAX_CPU);
+	int found = 0;
+	for (int32_t i = 0; i < n; ++i) {
+		if (cores[i] == core) {
+			found = 1;
+			break;
+		}
+	}
+	free(cores);
+	return found;
+}
+
+#endif
+
+#define PREFLIGHT_RECORD(fp, fmt, ...)              \
+	do {                                            \
+		LOG_INFO("preflight: " fmt, ##__VA_ARGS__); \
+		if (fp) {                                   \
+			fprintf(fp, fmt "\n", ##__VA_ARGS__);   \
+		}                                           \
+	} while (0)
+
+#define PREFLIGHT_WARN(fp, n_warning, fmt, ...)               \
+	do {                                                      \
+		LOG_WARNING("preflight: " fmt, ##__VA_ARGS__);        \
+		if (fp) {                                             \
+			fprintf(fp, "WARNING: " fmt "\n", ##__VA_ARGS__); \
+		}                                                     \
+		++(n_warning);                                        \
+	} while (0)
+
+int32_t c2c_benchmark_preflight(const char *name, const int32_t *cores,
+								int32_t n_core)
+{
+	int32_t n_warning = 0;
+
+	int32_t *all_cores = NULL;
+	if (cores == NULL) {
+		long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+		if (num_cores < 1) {
+			num_cores = 1;
+		}
+		all_cores = (int32_t *)malloc(sizeof(int32_t) * num_cores);
+		for (long i = 0; i < num_cores; ++i) {
+			all_cores[i] = (int32_t)i;
+		}
+		cores = all_cores;
+		n_core = (int32_t)num_cores;
+	}
+
+	char filepath[MUGGLE_MAX_PATH];
+	snprintf(filepath, sizeof(filepath),
+			 "./c2c_benchmark_reports/preflight_%s.txt", name);
+	FILE *fp = muggle_os_fopen(filepath, "w");
+	if (fp == NULL) {
+		LOG_ERROR("failed open preflight report: %s", filepath);
+	}
+
+	// scheduling and memory
+	if (s_sched_fifo_priority > 0) {
+		PREFLIGHT_RECORD(fp, "sched: SCHED_FIFO priority %d",
+						 s_sched_fifo_priority);
+	} else {
+		PREFLIGHT_RECORD(fp, "sched: SCHED_OTHER");
+	}
+	if (s_lock_memory) {
+#if MUGGLE_PLATFORM_LINUX
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+			char errmsg[256];
+			muggle_sys_strerror(errno, errmsg, sizeof(errmsg));
+			PREFLIGHT_WARN(fp, n_warning, "mlockall failed: %s", errmsg);
+		} else {
+			PREFLIGHT_RECORD(fp, "memory: mlockall");
+		}
+#else
+		PREFLIGHT_WARN(fp, n_warning,
+					   "mlockall is not supported on this platform");
+#endif
+	} else {
+		PREFLIGHT_RECORD(fp, "memory: not locked");
+	}
+
+#if MUGGLE_PLATFORM_LINUX
+	char buf[4096];
+	char isolated[1024];
+	char nohz_full[1024];
+	char s_filepath[MUGGLE_MAX_PATH];
+
+	if (preflight_read_line("/proc/cmdline", buf, sizeof(buf)) == 0) {
+		PREFLIGHT_RECORD(fp, "cmdline: %s", buf);
+	}
+	preflight_read_line("/sys/devices/system/cpu/isolated", isolated,
+						sizeof(isolated));
+	PREFLIGHT_RECORD(fp, "isolated: %s", isolated);
+	preflight_read_line("/sys/devices/system/cpu/nohz_full", nohz_full,
+						sizeof(nohz_full));
+	PREFLIGHT_RECORD(fp, "nohz_full: %s", nohz_full);
+
+	// turbo/boost
+	if (preflight_read_line("/sys/devices/system/cpu/intel_pstate/no_turbo",
+							buf, sizeof(buf)) == 0) {
+		PREFLIGHT_RECORD(fp, "intel_pstate no_turbo: %s", buf);
+		if (strcmp(buf, "0") == 0) {
+			PREFLIGHT_WARN(fp, n_warning, "turbo enabled");
+		}
+	}
+	if (preflight_read_line("/sys/devices/system/cpu/cpufreq/boost", buf,
+							sizeof(buf)) == 0) {
+		PREFLIGHT_RECORD(fp, "cpufreq boost: %s", buf);
+		if (strcmp(buf, "1") == 0) {
+			PREFLIGHT_WARN(fp, n_warning, "boost enabled");
+		}
+	}
+
+	// C-state limits
+	if (preflight_read_line("/sys/module/intel_idle/parameters/max_cstate",
+							buf, sizeof(buf)) == 0) {
+		PREFLIGHT_RECORD(fp, "intel_idle max_cstate: %s", buf);
+	}
+	if (preflight_read_line("/sys/module/processor/parameters/max_cstate",
+							buf, sizeof(buf)) == 0) {
+		PREFLIGHT_RECORD(fp, "processor max_cstate: %s", buf);
+	}
+
+	// per core
+	for (int32_t i = 0; i < n_core; ++i) {
+		int32_t core = cores[i];
+
+		int is_isolated = preflight_cpu_in_list(isolated, core);
+		int is_nohz_full = preflight_cpu_in_list(nohz_full, core);
+		PREFLIGHT_RECORD(fp, "cpu%d isolated: %d, nohz_full: %d", core,
+						 is_isolated, is_nohz_full);
+		if (!is_isolated) {
+			PREFLIGHT_WARN(fp, n_warning, "cpu%d is not isolated", core);
+		}
+
+		snprintf(s_filepath, sizeof(s_filepath),
+				 "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor",
+				 core);
+		if (preflight_read_line(s_filepath, buf, sizeof(buf)) == 0) {
+			PREFLIGHT_RECORD(fp, "cpu%d governor: %s", core, buf);
+			if (strcmp(buf, "performance") != 0) {
+				PREFLIGHT_WARN(fp, n_warning, "cpu%d governor is %s", core,
+							   buf);
+			}
+		}
+
+		const char *freq_files[] = { "scaling_cur_freq", "scaling_min_freq",
+									 "scaling_max_freq" };
+		for (size_t f = 0; f < sizeof(freq_files) / sizeof(freq_files[0]);
+			 ++f) {
+			snprintf(s_filepath, sizeof(s_filepath),
+					 "/sys/devices/system/cpu/cpu%d/cpufreq/%s", core,
+					 freq_files[f]);
+			if (preflight_read_line(s_filepath, buf, sizeof(buf)) == 0) {
+				PREFLIGHT_RECORD(fp, "cpu%d %s: %s kHz", core, freq_files[f],
+								 buf);
+			}
+		}
+
+		// enabled idle states deeper than C1
+		for (int32_t st = 0;; ++st) {
+			char st_name[64];
+			snprintf(s_filepath, sizeof(s_filepath),
+					 "/sys/devices/system/cpu/cpu%d/cpuidle/state%d/name",
+					 core, st);
+			if (preflight_read_line(s_filepath, st_name, sizeof(st_name)) !=
+				0) {
+				break;
+			}
+			snprintf(s_filepath, sizeof(s_filepath),
+					 "/sys/devices/system/cpu/cpu%d/cpuidle/state%d/disable",
+					 core, st);
+			preflight_read_line(s_filepath, buf, sizeof(buf));
+			int disabled = strcmp(buf, "1") == 0;
+			PREFLIGHT_RECORD(fp, "cpu%d idle state%d %s: %s", core, st,
+							 st_name, disabled ? "disabled" : "enabled");
+			if (!disabled && st > 1) {
+				PREFLIGHT_WARN(fp, n_warning, "cpu%d idle state %s enabled",
+							   core, st_name);
+			}
+		}
+	}
+
+	// IRQ affinity
+	DIR *dir = opendir("/proc/irq");
+	if (dir) {
+		struct dirent *entry;
+		while ((entry = readdir(dir)) != NULL) {
+			if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+				continue;
+			}
+			snprintf(s_filepath, sizeof(s_filepath),
+					 "/proc/irq/%s/smp_affinity_list", entry->d_name);
+			if (preflight_read_line(s_filepath, buf, sizeof(buf)) != 0) {
+				continue;
+			}
+			for (int32_t i = 0; i < n_core; ++i) {
+				if (preflight_cpu_in_list(buf, cores[i])) {
+					PREFLIGHT_WARN(fp, n_warning,
+								   "irq %s affinity %s includes cpu%d",
+								   entry->d_name, buf, cores[i]);
+					break;
+				}
+			}
+		}
+		closedir(dir);
+	} else {
+		PREFLIGHT_RECORD(fp, "irq affinity: /proc/irq not readable");
+	}
+#else
+	(void)cores;
+	(void)n_core;
+	PREFLIGHT_RECORD(fp, "host preflight is not supported on this platform");
+#endif
+
+	PREFLIGHT_RECORD(fp, "warnings: %d", n_warning);
+	if (fp) {
+		fclose(fp);
+		LOG_INFO("generate preflight report: %s", filepath);
+	}
+	if (all_cores) {
+		free(all_cores);
+	}
+
+	return n_warning;
+}
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *  @file         c2c_benchmark_preflight.h
+ *  @author       Muggle Wei
+ *  @email        mugglewei@gmail.com
+ *  @date         2025-08-02
+ *  @copyright    Copyright 2025 Muggle Wei
+ *  @license      MIT License
+ *  @brief        c2c benchmark scheduling, memory locking and host preflight
+ *****************************************************************************/
+
+#ifndef C2C_BENCHMARK_PREFLIGHT_H_
+#define C2C_BENCHMARK_PREFLIGHT_H_
+
+#include "c2c_benchmark.h"
+
+EXTERN_C_BEGIN
+
+#define C2C_BENCHMARK_PREFLIGHT_USAGE                               \
+	"  -R int\n"                                                    \
+	"    SCHED_FIFO priority of bound threads, 0 is SCHED_OTHER\n" \
+	"  -L\n"                                                        \
+	"    lock all memory with mlockall before run\n"
+
+/**
+ * @brief set SCHED_FIFO priority, applied by c2c_benchmark_bind_core
+ *
+ * @param priority  SCHED_FIFO priority, 0 means SCHED_OTHER
+ */
+void c2c_benchmark_set_sched_fifo(int32_t priority);
+
+/**
+ * @brief lock memory in c2c_benchmark_preflight
+ *
+ * @param enable  lock or not
+ */
+void c2c_benchmark_set_lock_memory(int32_t enable);
+
+/**
+ * @brief get configured SCHED_FIFO priority, 0 means SCHED_OTHER
+ */
+int32_t c2c_benchmark_get_sched_fifo(void);
+
+/**
+ * @brief get whether memory is locked in c2c_benchmark_preflight
+ */
+int32_t c2c_benchmark_get_lock_memory(void);
+
+/**
+ * @brief apply configured scheduling policy to calling thread
+ *
+ * @return
+ *     0 - success
+ *     otherwise - errno
+ */
+int c2c_benchmark_apply_sched(void);
+
+/**
+ * @brief run calling thread under SCHED_OTHER, threads created by a
+ * SCHED_FIFO thread inherit its policy
+ *
+ * @return
+ *     0 - success
+ *     otherwise - errno
+ */
+int c2c_benchmark_reset_sched(void);
+
+/**
+ * @brief lock memory if configured, then record host configuration of cores
+ *
+ * isolcpus/nohz_full, cpufreq governor, turbo/boost, C-state limits and
+ * IRQ affinity are written to
+ * ./c2c_benchmark_reports/preflight_<name>.txt and log, with warnings for
+ * configurations that widen the latency tail
+ *
+ * @param name    benchmark name
+ * @param cores   measured cores, NULL means all online cores
+ * @param n_core  number of measured cores
+ *
+ * @return number of warnings
+ */
+int32_t c2c_benchmark_preflight(const char *name, const int32_t *cores,
+								int32_t n_core);
+
+EXTERN_C_END
+
+#endif // !C2C_BENCHMARK_PREFLIGHT_H_
@@ -0,0 +1,160 @@
+#include "c2c_benchmark_skew.h"
+
+typedef union {
+	MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+	muggle_atomic_int v;
+} skew_line_t;
+
+typedef struct {
+	int32_t core_a;
+	int32_t core_b;
+	int32_t rounds;
+	skew_line_t ping;
+	skew_line_t pong;
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(3);
+		int64_t t1;
+	};
+	int64_t lower_ns;
+	int64_t upper_ns;
+} skew_ctx_t;
+
+static int64_t skew_now_ns(void)
+{
+	muggle_time_counter_t tc;
+	muggle_time_counter_start(&tc);
+	return (int64_t)tc.start_ts.tv_sec * 1000000000LL +
+		   (int64_t)tc.start_ts.tv_nsec;
+}
+
+static void skew_bind_core(const char *role, int32_t core)
+{
+	int ret = c2c_benchmark_bind_core(core);
+	if (ret != 0) {
+		char errmsg[256];
+		muggle_sys_strerror(ret, errmsg, sizeof(errmsg));
+		LOG_ERROR("failed skew %s bind CPU core, err=%s", role, errmsg);
+	}
+}
+
+static muggle_thread_ret_t proc_skew_a(void *p)
+{
+	skew_ctx_t *ctx = (skew_ctx_t *)p;
+	skew_bind_core("a", ctx->core_a);
+	c2c_benchmark_warmup(2);
+
+	int64_t lower = INT64_MIN;
+	int64_t upper = INT64_MAX;
+	for (int32_t i = 0; i < ctx->rounds; ++i) {
+		int64_t t0 = skew_now_ns();
+		muggle_atomic_store(&ctx->ping.v, i, muggle_memory_order_release);
+		while (muggle_atomic_load(&ctx->pong.v, muggle_memory_order_acquire) !=
+			   i)
+			;
+		int64_t t2 = skew_now_ns();
+		int64_t t1 = ctx->t1;
+
+		if (t1 - t2 > lower) {
+			lower = t1 - t2;
+		}
+		if (t1 - t0 < upper) {
+			upper = t1 - t0;
+		}
+	}
+	ctx->lower_ns = lower;
+	ctx->upper_ns = upper;
+
+	return 0;
+}
+
+static muggle_thread_ret_t proc_skew_b(void *p)
+{
+	skew_ctx_t *ctx = (skew_ctx_t *)p;
+	skew_bind_core("b", ctx->core_b);
+	c2c_benchmark_warmup(2);
+
+	for (int32_t i = 0; i < ctx->rounds; ++i) {
+		while (muggle_atomic_load(&ctx->ping.v, muggle_memory_order_acquire) !=
+			   i)
+			;
+		ctx->t1 = skew_now_ns();
+		muggle_atomic_store(&ctx->pong.v, i, muggle_memory_order_release);
+	}
+
+	return 0;
+}
+
+int c2c_benchmark_skew_estimate(int32_t core_a, int32_t core_b,
+								int32_t rounds, c2c_benchmark_skew_t *skew)
+{
+	memset(skew, 0, sizeof(*skew));
+	skew->core_a = core_a;
+	skew->core_b = core_b;
+	if (rounds < 1) {
+		return -1;
+	}
+
+	skew_ctx_t *ctx = (skew_ctx_t *)malloc(sizeof(skew_ctx_t));
+	if (ctx == NULL) {
+		LOG_ERROR("failed allocate skew context");
+		return -1;
+	}
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->core_a = core_a;
+	ctx->core_b = core_b;
+	ctx->rounds = rounds;
+	ctx->ping.v = -1;
+	ctx->pong.v = -1;
+
+	muggle_thread_t th_a, th_b;
+	muggle_thread_create(&th_b, proc_skew_b, ctx);
+	muggle_thread_create(&th_a, proc_skew_a, ctx);
+	muggle_thread_join(&th_a);
+	muggle_thread_join(&th_b);
+
+	skew->lower_ns = ctx->lower_ns;
+	skew->upper_ns = ctx->upper_ns;
+	skew->offset_ns = (ctx->lower_ns + ctx->upper_ns) / 2;
+	skew->error_ns = (ctx->upper_ns - ctx->lower_ns) / 2;
+	skew->valid = ctx->lower_ns <= ctx->upper_ns;
+	free(ctx);
+
+	if (!skew->valid) {
+		LOG_WARNING("clock skew c%d -> c%d invalid, lower bound %lld ns > "
+					"upper bound %lld ns",
+					core_a, core_b, (long long)skew->lower_ns,
+					(long long)skew->upper_ns);
+		return -1;
+	}
+
+	LOG_INFO("clock skew c%d -> c%d: offset %lld ns, error %lld ns, "
+			 "bounds [%lld, %lld]",
+			 core_a, core_b, (long long)skew->offset_ns,
+			 (long long)skew->error_ns, (long long)skew->lower_ns,
+			 (long long)skew->upper_ns);
+
+	return 0;
+}
+
+void c2c_benchmark_skew_correct(const c2c_benchmark_skew_t *skew,
+								cache_line_data_t *datas, size_t total_cnt)
+{
+	if (!skew->valid) {
+		return;
+	}
+
+	for (size_t i = 0; i < total_cnt; ++i) {
+		struct timespec *ts = &datas[i].tc.end_ts;
+		int64_t ns = (int64_t)ts->tv_sec * 1000000000LL + (int64_t)ts->tv_nsec;
+		ns -= skew->offset_ns;
+		ts->tv_sec = (time_t)(ns / 1000000000LL);
+		ts->tv_nsec = (long)(ns % 1000000000LL);
+	}
+}
+
+int64_t c2c_benchmark_skew_bound(const c2c_benchmark_skew_t *skew)
+{
+	int64_t lower = skew->lower_ns < 0 ? -skew->lower_ns : skew->lower_ns;
+	int64_t upper = skew->upper_ns < 0 ? -skew->upper_ns : skew->upper_ns;
+	return lower > upper ? lower : upper;
+}
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *  @file         c2c_benchmark_skew.h
+ *  @author       Muggle Wei
+ *  @email        mugglewei@gmail.com
+ *  @date         2025-08-02
+ *  @copyright    Copyright 2025 Muggle Wei
+ *  @license      MIT License
+ *  @brief        c2c benchmark cross core clock skew estimation
+ *****************************************************************************/
+
+#ifndef C2C_BENCHMARK_SKEW_H_
+#define C2C_BENCHMARK_SKEW_H_
+
+#include "c2c_benchmark.h"
+
+EXTERN_C_BEGIN
+
+/**
+ * @brief skew of core_b clock relative to core_a clock
+ *
+ * clock_b - clock_a is in [lower_ns, upper_ns]; if lower_ns > upper_ns the
+ * bounds contradict each other (e.g. a core clock stepped), the estimate is
+ * invalid and must not be used to correct timestamps
+ */
+typedef struct {
+	int32_t core_a;
+	int32_t core_b;
+	int64_t lower_ns;
+	int64_t upper_ns;
+	int64_t offset_ns; //!< (lower_ns + upper_ns) / 2
+	int64_t error_ns; //!< (upper_ns - lower_ns) / 2
+	int32_t valid; //!< 1 if lower_ns <= upper_ns
+} c2c_benchmark_skew_t;
+
+/**
+ * @brief estimate clock skew with round trip handshakes
+ *
+ * core_a timestamps t0, core_b timestamps t1, core_a timestamps t2, so
+ * t1 - t2 <= clock_b - clock_a <= t1 - t0; bounds of all rounds are
+ * intersected
+ *
+ * @param core_a  core take start timestamp
+ * @param core_b  core take end timestamp
+ * @param rounds  number of round trips
+ * @param skew    output skew
+ *
+ * @return
+ *     0 - success
+ *     otherwise - failed or bounds are inconsistent, skew->valid is 0
+ */
+int c2c_benchmark_skew_estimate(int32_t core_a, int32_t core_b,
+								int32_t rounds, c2c_benchmark_skew_t *skew);
+
+/**
+ * @brief correct end timestamps taken on core_b into core_a clock, do
+ * nothing if skew is invalid
+ *
+ * @param skew       skew
+ * @param datas      time counter array
+ * @param total_cnt  total count
+ */
+void c2c_benchmark_skew_correct(const c2c_benchmark_skew_t *skew,
+								cache_line_data_t *datas, size_t total_cnt);
+
+/**
+ * @brief max possible absolute skew
+ *
+ * @param skew  skew
+ *
+ * @return max(|lower_ns|, |upper_ns|)
+ */
+int64_t c2c_benchmark_skew_bound(const c2c_benchmark_skew_t *skew);
+
+EXTERN_C_END
+
+#endif // !C2C_BENCHMARK_SKEW_H_
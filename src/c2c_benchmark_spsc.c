@@ -0,0 +1,79 @@
+#include "c2c_benchmark_spsc.h"
+
+int c2c_benchmark_spsc_init(c2c_benchmark_spsc_t *ring, uint32_t capacity,
+							uint32_t slot_size)
+{
+	memset(ring, 0, sizeof(*ring));
+
+	uint32_t n = 1;
+	while (n < capacity) {
+		n <<= 1;
+	}
+	slot_size = (slot_size + 63) & ~(uint32_t)63;
+	if (slot_size == 0) {
+		slot_size = 64;
+	}
+
+	ring->mem = (char *)malloc((size_t)n * slot_size + 4096);
+	if (ring->mem == NULL) {
+		return -1;
+	}
+	ring->slots = (char *)(((uintptr_t)ring->mem + 4095) & ~(uintptr_t)4095);
+	memset(ring->slots, 0, (size_t)n * slot_size);
+
+	ring->capacity = n;
+	ring->slot_size = slot_size;
+
+	return 0;
+}
+
+void c2c_benchmark_spsc_destroy(c2c_benchmark_spsc_t *ring)
+{
+	free(ring->mem);
+	ring->mem = NULL;
+	ring->slots = NULL;
+}
+
+void *c2c_benchmark_spsc_w_alloc(c2c_benchmark_spsc_t *ring)
+{
+	uint32_t w = ring->w_local;
+	if (w - ring->w_cached_r >= ring->capacity) {
+		ring->w_cached_r = (uint32_t)muggle_atomic_load(
+			&ring->r_pos, muggle_memory_order_acquire);
+		if (w - ring->w_cached_r >= ring->capacity) {
+			return NULL;
+		}
+	}
+	return ring->slots + (size_t)(w & (ring->capacity - 1)) * ring->slot_size;
+}
+
+void c2c_benchmark_spsc_w_move(c2c_benchmark_spsc_t *ring)
+{
+	ring->w_local++;
+	muggle_atomic_store(&ring->w_pos, (int)ring->w_local,
+						muggle_memory_order_release);
+}
+
+uint32_t c2c_benchmark_spsc_r_available(c2c_benchmark_spsc_t *ring)
+{
+	uint32_t n = ring->r_cached_w - ring->r_local;
+	if (n == 0) {
+		ring->r_cached_w = (uint32_t)muggle_atomic_load(
+			&ring->w_pos, muggle_memory_order_acquire);
+		n = ring->r_cached_w - ring->r_local;
+	}
+	return n;
+}
+
+void *c2c_benchmark_spsc_r_slot(c2c_benchmark_spsc_t *ring, uint32_t i)
+{
+	uint32_t r = ring->r_local + i;
+	return ring->slots + (size_t)(r & (ring->capacity - 1)) * ring->slot_size;
+}
+
+void c2c_benchmark_spsc_r_move(c2c_benchmark_spsc_t *ring, uint32_t n)
+{
+	ring->r_local += n;
+	muggle_atomic_store(&ring->r_pos, (int)ring->r_local,
+						muggle_memory_order_release);
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+ *  @file         c2c_benchmark_spsc.h
+ *  @author       Muggle Wei
+ *  @email        mugglewei@gmail.com
+ *  @date         2025-08-02
+ *  @copyright    Copyright 2025 Muggle Wei
+ *  @license      MIT License
+ *  @brief        c2c benchmark minimal single producer single consumer ring
+ *****************************************************************************/
+
+#ifndef C2C_BENCHMARK_SPSC_H_
+#define C2C_BENCHMARK_SPSC_H_
+
+#include "c2c_benchmark.h"
+
+EXTERN_C_BEGIN
+
+/**
+ * @brief fixed slot SPSC ring
+ *
+ * Reader may consume several slots in place and publish the read position
+ * once, see c2c_benchmark_spsc_r_move. The ring is cache line aligned, so
+ * heap allocated containers of it need 64 bytes alignment too.
+ */
+typedef struct {
+	union {
+		_Alignas(64) MUGGLE_STRUCT_CACHE_LINE_PADDING(0);
+		struct {
+			uint32_t capacity;
+			uint32_t slot_size;
+			char *mem;
+			char *slots;
+		};
+	};
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(1);
+		muggle_atomic_int w_pos;
+	};
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(2);
+		muggle_atomic_int r_pos;
+	};
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(3);
+		struct {
+			uint32_t w_local; //!< writer local position
+			uint32_t w_cached_r; //!< writer cached read position
+		};
+	};
+	union {
+		MUGGLE_STRUCT_CACHE_LINE_PADDING(4);
+		struct {
+			uint32_t r_local; //!< reader local position
+			uint32_t r_cached_w; //!< reader cached write position
+		};
+	};
+} c2c_benchmark_spsc_t;
+
+/**
+ * @brief init spsc ring
+ *
+ * @param ring       spsc ring
+ * @param capacity   number of slots, round up to power of 2
+ * @param slot_size  bytes of slot, round up to cache line
+ *
+ * @return
+ *     0 - success
+ *     otherwise - failed
+ */
+int c2c_benchmark_spsc_init(c2c_benchmark_spsc_t *ring, uint32_t capacity,
+							uint32_t slot_size);
+
+/**
+ * @brief destroy spsc ring
+ *
+ * @param ring  spsc ring
+ */
+void c2c_benchmark_spsc_destroy(c2c_benchmark_spsc_t *ring);
+
+/**
+ * @brief writer get next free slot
+ *
+ * @param ring  spsc ring
+ *
+ * @return slot, NULL if ring is full
+ */
+void *c2c_benchmark_spsc_w_alloc(c2c_benchmark_spsc_t *ring);
+
+/**
+ * @brief writer publish slot returned by c2c_benchmark_spsc_w_alloc
+ *
+ * @param ring  spsc ring
+ */
+void c2c_benchmark_spsc_w_move(c2c_benchmark_spsc_t *ring);
+
+/**
+ * @brief reader get number of readable slots
+ *
+ * @param ring  spsc ring
+ *
+ * @return number of readable slots
+ */
+uint32_t c2c_benchmark_spsc_r_available(c2c_benchmark_spsc_t *ring);
+
+/**
+ * @brief reader get i-th unconsumed slot, i < c2c_benchmark_spsc_r_available
+ *
+ * @param ring  spsc ring
+ * @param i     offset from current read position
+ *
+ * @return slot
+ */
+void *c2c_benchmark_spsc_r_slot(c2c_benchmark_spsc_t *ring, uint32_t i);
+
+/**
+ * @brief reader release n slots and publish read position once
+ *
+ * @param ring  spsc ring
+ * @param n     number of slots
+ */
+void c2c_benchmark_spsc_r_move(c2c_benchmark_spsc_t *ring, uint32_t n);
+
+EXTERN_C_END
+
+#endif // !C2C_BENCHMARK_SPSC_H_